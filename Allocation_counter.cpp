@@ -0,0 +1,58 @@
+/*
+ @file      Allocation_counter.cpp
+ @brief     replaces the global operator new in debug builds so that the
+            number of heap allocations made by each thread can be checked
+ @author    Luke Eure
+ @date      March 4 2016
+*/
+
+#include "Allocation_counter.h"
+
+#ifdef DEBUG
+
+#include <new>
+#include <stdlib.h>
+
+/** number of heap allocations made by this thread */
+static thread_local long _allocation_count = 0;
+
+/*
+ @brief     allocates memory on the heap, counting the allocation
+ @param     size the number of bytes to allocate
+ @return    a pointer to the allocated memory
+*/
+void* operator new(std::size_t size) {
+    _allocation_count++;
+    void* memory = malloc(size == 0 ? 1 : size);
+    if (memory == NULL)
+        throw std::bad_alloc();
+    return memory;
+}
+
+/*
+ @brief     frees memory allocated by operator new
+ @param     memory a pointer to the memory to free
+*/
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+/*
+ @brief     frees memory allocated by operator new
+ @param     memory a pointer to the memory to free
+ @param     size the number of bytes allocated
+*/
+void operator delete(void* memory, std::size_t size) noexcept {
+    free(memory);
+}
+
+/*
+ @brief     returns the number of heap allocations made so far by the
+            calling thread
+ @return    the number of heap allocations
+*/
+long getAllocationCount() {
+    return _allocation_count;
+}
+
+#endif
@@ -0,0 +1,15 @@
+/*
+ @file      Allocation_counter.h
+ @brief     counts heap allocations in debug builds
+ @author    Luke Eure
+ @date      March 4 2016
+*/
+
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#ifdef DEBUG
+long getAllocationCount();
+#endif
+
+#endif
@@ -21,8 +21,11 @@ Boundaries::~Boundaries() {}
  @brief     set the surfaces into the geometry
  @paraam    axis 0, 1, or 2 corresponding to x y and z
  @param     side 0 or 1 corresponding to the minimum or maximum of the geometry
+ @param     surface a surface at a position along the axis, which becomes a
+            plane normal to the axis
 */
 void Boundaries::setSurface(Axes axis, min_max side, Surface* surface) {
+    surface->setAxis(axis);
     _surfaces[2*axis + side] = surface;
 }
 
@@ -50,16 +53,13 @@ BoundaryType Boundaries::getSurfaceType(int axis, int side) {
  @brief     function that samples a random location within a bounding box.
  @details   a point is randomly and uniformally sampled in the bounding box 
             provided in the input.
- @param     bounds a Boundaries object containing the limits of the
-            bounding box
- @return    _dist_location a vector that contains the coordinates of a point
+ @param     neutron the neutron whose random number stream is used
+ @param     location an array of three coordinates to fill with the point
 */
-std::vector <double> Boundaries::sampleLocation(Neutron* neutron) {
-    std::vector <double> _dist_location(3);
+void Boundaries::sampleLocation(Neutron* neutron, double* location) {
     for (int axis=0; axis<3; ++axis) {
         double width = getSurfaceCoord(axis, MAX) - getSurfaceCoord(axis, MIN);
         double coord = getSurfaceCoord(axis, MIN) + width * neutron->arand();
-        _dist_location[axis] = coord;
+        location[axis] = coord;
     }
-    return _dist_location;
 }
@@ -22,7 +22,7 @@ public:
     float getSurfaceCoord(int axis, int side);
     BoundaryType getSurfaceType(int axis, int side);
     void setSurface(Axes axis, min_max side, Surface* surface);
-    std::vector <double> sampleLocation(Neutron* neutron);
+    void sampleLocation(Neutron* neutron, double* location);
 
 private:
 
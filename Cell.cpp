@@ -0,0 +1,173 @@
+/*
+ @file      Cell.cpp
+ @brief     contains functions for the Cell class
+ @author    Luke Eure
+ @date      April 5 2016
+*/
+
+#include "Cell.h"
+
+/*
+ @brief     constructor for Cell class, making a cell with no bounding
+            surfaces
+ @param     material the material filling the cell
+*/
+Cell::Cell(Material* material) {
+    _material = material;
+    _lattice = NULL;
+}
+
+/*
+ @brief     constructor for Cell class, making a cell with no bounding
+            surfaces filled with a lattice
+ @param     lattice the lattice filling the cell, in the coordinates of the
+            cell's universe
+*/
+Cell::Cell(Lattice* lattice) {
+    _material = NULL;
+    _lattice = lattice;
+}
+
+/*
+ @brief     deconstructor
+*/
+Cell::~Cell() {}
+
+/*
+ @brief     bounds the cell by one side of a surface
+ @param     surface the surface
+ @param     sense 1 if the cell is on the positive side of the surface, -1 if
+            it is on the negative side
+*/
+void Cell::addSurface(Surface* surface, int sense) {
+    if (_surfaces.size() == MAX_CELL_SURFACES) {
+        std::cout << "A cell can have at most " << MAX_CELL_SURFACES
+            << " surfaces" << std::endl;
+        return;
+    }
+    _surfaces.push_back(surface);
+    _senses.push_back(sense > 0 ? 1 : -1);
+    double coefficients[NUM_SURFACE_COEFFICIENTS];
+    surface->getCoefficients(coefficients);
+    for (int i=0; i<NUM_SURFACE_COEFFICIENTS; ++i)
+        _coefficients[i].push_back(coefficients[i]);
+}
+
+/*
+ @brief     checks whether a neutron is in the cell. A neutron on a bounding
+            surface is in the cell if it is heading into it.
+ @param     position the location of the neutron
+ @param     direction the direction of travel of the neutron
+ @return    true if the neutron is in the cell
+*/
+bool Cell::contains(double* position, double* direction) {
+    for (int s=0; s<_surfaces.size(); ++s) {
+        double value = _surfaces[s]->evaluate(position);
+        if (fabs(value) < SURFACE_TOLERANCE) {
+            double normal[3];
+            _surfaces[s]->getNormal(position, normal);
+            value = normal[0] * direction[0] + normal[1] * direction[1]
+                + normal[2] * direction[2];
+        }
+        if (value * _senses[s] <= 0.0)
+            return false;
+    }
+    return true;
+}
+
+/*
+ @brief     finds the distance along a neutron's direction of travel to the
+            nearest bounding surface of the cell
+ @details   along the path p + t u the surface function is the quadratic
+            a' t^2 + 2 k t + c, with a' = a (ux^2 + uy^2),
+            k = a (px ux + py uy) + (b ux + c uy + d uz) / 2 and c = f(p).
+            Its smallest root beyond SURFACE_TOLERANCE is found for every
+            surface in one branch-free loop.
+ @param     position the location of the neutron, inside the cell
+ @param     direction the direction of travel of the neutron
+ @param     surface_index set to the index of the nearest surface, or -1 if
+            no surface is ahead
+ @return    the distance to the nearest surface, infinite if there is none
+*/
+double Cell::getBoundaryDistance(double* position, double* direction,
+        int* surface_index) {
+    double distances[MAX_CELL_SURFACES];
+    int num_surfaces = _surfaces.size();
+    double* a = &_coefficients[0][0];
+    double* b = &_coefficients[1][0];
+    double* c = &_coefficients[2][0];
+    double* d = &_coefficients[3][0];
+    double* e = &_coefficients[4][0];
+    double px = position[0];
+    double py = position[1];
+    double pz = position[2];
+    double ux = direction[0];
+    double uy = direction[1];
+    double uz = direction[2];
+
+    #pragma omp simd
+    for (int s=0; s<num_surfaces; ++s) {
+        double quadratic = a[s] * (ux * ux + uy * uy);
+        double half_linear = a[s] * (px * ux + py * uy)
+            + 0.5 * (b[s] * ux + c[s] * uy + d[s] * uz);
+        double constant = a[s] * (px * px + py * py) + b[s] * px + c[s] * py
+            + d[s] * pz + e[s];
+
+        // the root of a plane, or the nearer root of a cylinder that is
+        // ahead, then the farther one
+        double plane_root = -constant / (2.0 * half_linear);
+        double discriminant = half_linear * half_linear
+            - quadratic * constant;
+        double root = sqrt(discriminant > 0.0 ? discriminant : 0.0);
+        double near_root = (-half_linear - root) / quadratic;
+        double far_root = (-half_linear + root) / quadratic;
+        double cylinder_root = near_root > SURFACE_TOLERANCE ? near_root
+            : far_root;
+        cylinder_root = discriminant < 0.0 ? INFINITY : cylinder_root;
+        double distance = quadratic == 0.0 ? plane_root : cylinder_root;
+        distances[s] = distance > SURFACE_TOLERANCE ? distance : INFINITY;
+    }
+
+    double nearest = INFINITY;
+    *surface_index = -1;
+    for (int s=0; s<num_surfaces; ++s) {
+        if (distances[s] < nearest) {
+            nearest = distances[s];
+            *surface_index = s;
+        }
+    }
+    return nearest;
+}
+
+/*
+ @brief     returns the number of bounding surfaces
+ @return    the number of surfaces
+*/
+int Cell::getNumSurfaces() {
+    return _surfaces.size();
+}
+
+/*
+ @brief     returns a bounding surface
+ @param     index the position of the surface in the order it was added
+ @return    a pointer to the surface
+*/
+Surface* Cell::getSurface(int index) {
+    return _surfaces[index];
+}
+
+/*
+ @brief     returns the material filling the cell
+ @return    a pointer to the material, or NULL if a lattice fills the cell
+*/
+Material* Cell::getMaterial() {
+    return _material;
+}
+
+/*
+ @brief     returns the lattice filling the cell
+ @return    a pointer to the lattice, or NULL if a material fills the cell
+*/
+Lattice* Cell::getLattice() {
+    return _lattice;
+}
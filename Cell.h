@@ -0,0 +1,68 @@
+/*
+ @file      Cell.h
+ @brief     contains the Cell class
+ @author    Luke Eure
+ @date      April 5 2016
+*/
+
+#ifndef CELL_H
+#define CELL_H
+
+#include <iostream>
+#include <vector>
+#include <math.h>
+
+#include "Surface.h"
+#include "Material.h"
+
+class Lattice;
+
+/** largest number of surfaces bounding a cell */
+const int MAX_CELL_SURFACES = 64;
+
+/** points closer than this to a surface are taken to be on it, and
+    crossings closer than this are ignored */
+const double SURFACE_TOLERANCE = 1e-10;
+
+/*
+ @brief     a region bounded by surfaces, filled with a material or a
+            lattice of universes
+ @details   the cell is the intersection of one side of each of its
+            surfaces. The coefficients of the surfaces are copied into one
+            array per coefficient, so the distances to all of them are found
+            in one loop the compiler can vectorize.
+*/
+class Cell {
+
+public:
+    Cell(Material* material);
+    Cell(Lattice* lattice);
+    virtual ~Cell();
+
+    void addSurface(Surface* surface, int sense);
+    bool contains(double* position, double* direction);
+    double getBoundaryDistance(double* position, double* direction,
+            int* surface_index);
+    int getNumSurfaces();
+    Surface* getSurface(int index);
+    Material* getMaterial();
+    Lattice* getLattice();
+
+private:
+
+    /** the material filling the cell, or NULL if a lattice fills it */
+    Material* _material;
+
+    /** the lattice filling the cell, or NULL if a material fills it */
+    Lattice* _lattice;
+
+    /** the bounding surfaces, and the side of each the cell is on: 1 for
+        the positive side and -1 for the negative side */
+    std::vector <Surface*> _surfaces;
+    std::vector <int> _senses;
+
+    /** each coefficient of every bounding surface */
+    std::vector <double> _coefficients[NUM_SURFACE_COEFFICIENTS];
+};
+
+#endif
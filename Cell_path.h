@@ -0,0 +1,57 @@
+/*
+ @file      Cell_path.h
+ @brief     contains the CellPath struct
+ @author    Luke Eure
+ @date      April 9 2016
+*/
+
+#ifndef CELL_PATH_H
+#define CELL_PATH_H
+
+class Geometry;
+class Material;
+
+/** deepest nesting of universes inside lattices, counting the root
+    geometry */
+const int MAX_UNIVERSE_LEVELS = 8;
+
+/*
+ @brief     where a neutron is in a geometry of nested universes
+ @details   level 0 is the root geometry. Each level above it is the
+            universe filling an element of the lattice that fills the cell
+            of the level below. A universe is positioned in its element by
+            translation only, so a neutron's direction is the same at every
+            level and its position in a level's coordinates is its position
+            less that level's offset.
+*/
+struct CellPath {
+
+    /** the number of levels the neutron is in, 0 if it is in no cell */
+    int num_levels;
+
+    /** the universe at each level */
+    Geometry* universes[MAX_UNIVERSE_LEVELS];
+
+    /** the index of the cell holding the neutron in each universe */
+    int cells[MAX_UNIVERSE_LEVELS];
+
+    /** the element holding the neutron of the lattice filling the cell at
+        each level below the last */
+    int elements[MAX_UNIVERSE_LEVELS][3];
+
+    /** the origin of each level's coordinates in the root's coordinates */
+    double offsets[MAX_UNIVERSE_LEVELS][3];
+
+    /** the material filling the cell at the last level */
+    Material* material;
+
+    /** the level of the nearest surface found by
+        Geometry::getBoundaryDistance(), the index of the surface among the
+        bounding surfaces of the level's cell or -1 for the edge of an
+        element of the level's lattice, and the axis the edge is normal to */
+    int crossing_level;
+    int crossing_surface;
+    int crossing_axis;
+};
+
+#endif
@@ -0,0 +1,274 @@
+/*
+ @file      Checkpoint.cpp
+ @brief     functions for saving and resuming an eigenvalue run
+ @details   a checkpoint holds everything a run needs to carry on after a
+            batch: the fission sites banked in it, the source entropies
+            and k estimates so far, the statistics of every tally and of
+            the flux, and the sums the coarse mesh of CMFD is built from.
+            The random number streams are keyed by the seed,
+            batch and history, so they need no saving, and a resumed run
+            gives the same results as one that was never stopped.
+            The file is written in native byte order: the 8 byte magic
+            "MGMCCHKP", then as 32 bit integers the format version, the
+            number of histories per batch, the batch, the first active batch
+            (or -1 if the run was still inactive), the number of tallies and
+            the number of k estimators, then a series of arrays of doubles,
+            each preceded by its length as a 64 bit integer: the fission
+            bank, the entropies, the k estimates of each batch, the sums
+            and sums of squares of each tally, and the sums and sums of
+            squares of the flux, and the CMFD state, empty if the run has
+            no CMFD. The statistics of a tally or of the flux are preceded
+            by their number of batches as a 32 bit integer.
+ @author    Luke Eure
+ @date      March 24 2016
+*/
+
+#include "Checkpoint.h"
+
+/*
+ @brief     writes an array preceded by its length
+ @param     file the file to write to
+ @param     values the array
+ @param     count the number of values
+*/
+static void writeArray(FILE* file, double* values, int64_t count) {
+    fwrite(&count, sizeof(count), 1, file);
+    if (count > 0)
+        fwrite(values, sizeof(double), count, file);
+}
+
+/*
+ @brief     reads an array of any length
+ @param     file the file to read from
+ @param     values filled with the array
+ @return    true if the array was read
+*/
+static bool readArray(FILE* file, std::vector <double> &values) {
+    int64_t count;
+    if (fread(&count, sizeof(count), 1, file) != 1 || count < 0)
+        return false;
+    values.resize(count);
+    return count == 0
+        || fread(&values[0], sizeof(double), count, file) == count;
+}
+
+/*
+ @brief     reads an array whose length is known
+ @param     file the file to read from
+ @param     values an array to fill
+ @param     count the number of values expected
+ @return    true if the array was read and had the expected length
+*/
+static bool readArray(FILE* file, double* values, int64_t count) {
+    int64_t file_count;
+    if (fread(&file_count, sizeof(file_count), 1, file) != 1
+            || file_count != count)
+        return false;
+    return count == 0 || fread(values, sizeof(double), count, file) == count;
+}
+
+/*
+ @brief     reads the header of a checkpoint file and the fission bank,
+            keeping this rank's share of the bank
+ @param     file the file to read from
+ @param     header filled with the integers of the header
+ @param     fission_banks the fission bank to load the sites into
+ @return    true if the file is a checkpoint and was read
+*/
+static bool readHeaderAndSource(FILE* file, int32_t* header,
+        Fission &fission_banks) {
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic)
+            || memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0
+            || fread(header, sizeof(int32_t), 6, file) != 6
+            || header[0] != CHECKPOINT_VERSION)
+        return false;
+
+    std::vector <double> sites;
+    if (!readArray(file, sites))
+        return false;
+    long num_sites = sites.size() / SITE_SIZE;
+    long first_site = num_sites * getRank() / getNumRanks();
+    long last_site = num_sites * (getRank() + 1) / getNumRanks();
+    std::vector <double> &banked_sites = fission_banks.getBankedSites();
+    banked_sites.assign(sites.begin() + first_site * SITE_SIZE,
+            sites.begin() + last_site * SITE_SIZE);
+    return true;
+}
+
+/*
+ @brief     saves the state of a run at the end of a batch. Every process
+            must call it; the first one writes the file.
+ @param     file_name the name of the file to write
+ @param     n_histories the number of histories in each batch
+ @param     batch the batch just finished
+ @param     first_active the first active batch, or a later batch than
+            this one if the run is still inactive
+ @param     fission_banks the fission bank holding the sites banked in
+            the batch
+ @param     entropies the source entropy of each batch
+ @param     k_samples the k estimates of each active batch
+ @param     tallies the tallies of the run
+ @param     mesh a Mesh object containing the flux
+ @param     cmfd the coarse mesh accelerating the run, or NULL for none
+*/
+void writeCheckpoint(std::string file_name, int n_histories, int batch,
+        int first_active, Fission &fission_banks,
+        std::vector <double> &entropies,
+        std::vector <std::vector <double> > &k_samples,
+        std::vector <Tally*> &tallies, Mesh &mesh, Cmfd* cmfd) {
+
+    // gather the whole fission bank on the first process
+    std::vector <double> sites = fission_banks.getBankedSites();
+    long num_sites = getGlobalSiteCount(sites, SITE_SIZE);
+    std::vector <double> received;
+    redistributeSites(sites, SITE_SIZE, getRank() == 0 ? 0 : num_sites,
+            num_sites, received);
+    if (getRank() != 0)
+        return;
+
+    // write to a temporary file and move it into place, so a run dying
+    // part way through a write leaves the last checkpoint intact
+    std::string temporary_name = file_name + ".tmp";
+    FILE* file = fopen(temporary_name.c_str(), "wb");
+    if (file == NULL) {
+        std::cout << "Could not open " << temporary_name << " for writing"
+            << std::endl;
+        return;
+    }
+    int num_estimators = k_samples.size() > 0 ? k_samples[0].size() : 0;
+    int32_t header[] = {CHECKPOINT_VERSION, n_histories, batch,
+        first_active <= batch ? first_active : -1, (int32_t) tallies.size(),
+        num_estimators};
+    fwrite(CHECKPOINT_MAGIC, 1, sizeof(CHECKPOINT_MAGIC), file);
+    fwrite(header, sizeof(header), 1, file);
+    writeArray(file, sites.size() > 0 ? &sites[0] : NULL, sites.size());
+    writeArray(file, entropies.size() > 0 ? &entropies[0] : NULL,
+            entropies.size());
+    std::vector <double> flat_samples;
+    for (int b=0; b<k_samples.size(); ++b)
+        flat_samples.insert(flat_samples.end(), k_samples[b].begin(),
+                k_samples[b].end());
+    writeArray(file, flat_samples.size() > 0 ? &flat_samples[0] : NULL,
+            flat_samples.size());
+    for (int t=0; t<tallies.size(); ++t) {
+        int32_t num_batches = tallies[t]->getNumBatches();
+        fwrite(&num_batches, sizeof(num_batches), 1, file);
+        writeArray(file, tallies[t]->getSums(), tallies[t]->getSize());
+        writeArray(file, tallies[t]->getSquaredSums(),
+                tallies[t]->getSize());
+    }
+    int32_t num_flux_batches = mesh.getNumFluxBatches();
+    fwrite(&num_flux_batches, sizeof(num_flux_batches), 1, file);
+    writeArray(file, mesh.getFlux().getValues(), mesh.getFlux().getSize());
+    writeArray(file, mesh.getFluxSquared().getValues(),
+            mesh.getFluxSquared().getSize());
+    std::vector <double> cmfd_state;
+    if (cmfd != NULL)
+        cmfd->getState(cmfd_state);
+    writeArray(file, cmfd_state.size() > 0 ? &cmfd_state[0] : NULL,
+            cmfd_state.size());
+    fclose(file);
+    rename(temporary_name.c_str(), file_name.c_str());
+}
+
+/*
+ @brief     restores the state of a run from a checkpoint. Every process
+            reads the file and keeps its share of the fission bank.
+ @param     file_name the name of the checkpoint file
+ @param     n_histories the number of histories in each batch, which must
+            match the checkpoint
+ @param     batch set to the last batch finished
+ @param     first_active set to the first active batch, or left alone if
+            the run was still inactive
+ @param     fission_banks the fission bank to load the banked sites into
+ @param     entropies filled with the source entropy of each batch
+ @param     k_samples filled with the k estimates of each active batch
+ @param     tallies the tallies of the run, with the same filters and
+            scores as when the checkpoint was written
+ @param     mesh a Mesh object with the same flux shape as when the
+            checkpoint was written
+ @param     cmfd the coarse mesh accelerating the run, with the same cells
+            as when the checkpoint was written, or NULL for none
+ @return    true if the run was restored
+*/
+bool readCheckpoint(std::string file_name, int n_histories, int* batch,
+        int* first_active, Fission &fission_banks,
+        std::vector <double> &entropies,
+        std::vector <std::vector <double> > &k_samples,
+        std::vector <Tally*> &tallies, Mesh &mesh, Cmfd* cmfd) {
+    FILE* file = fopen(file_name.c_str(), "rb");
+    if (file == NULL) {
+        std::cout << "Could not open checkpoint " << file_name << std::endl;
+        return false;
+    }
+
+    int32_t header[6];
+    bool read = readHeaderAndSource(file, header, fission_banks);
+    if (read && (header[1] != n_histories || header[4] != tallies.size())) {
+        std::cout << "Checkpoint " << file_name << " was written by a run "
+            << "with different histories per batch or tallies" << std::endl;
+        fclose(file);
+        return false;
+    }
+
+    std::vector <double> flat_samples;
+    read = read && readArray(file, entropies)
+        && readArray(file, flat_samples);
+    k_samples.clear();
+    for (long i=0; header[5] > 0 && i<flat_samples.size(); i+=header[5])
+        k_samples.push_back(std::vector <double>(flat_samples.begin() + i,
+                    flat_samples.begin() + i + header[5]));
+    for (int t=0; read && t<tallies.size(); ++t) {
+        int32_t num_batches;
+        read = fread(&num_batches, sizeof(num_batches), 1, file) == 1
+            && readArray(file, tallies[t]->getSums(), tallies[t]->getSize())
+            && readArray(file, tallies[t]->getSquaredSums(),
+                    tallies[t]->getSize());
+        tallies[t]->setNumBatches(num_batches);
+    }
+    int32_t num_flux_batches;
+    read = read && fread(&num_flux_batches, sizeof(num_flux_batches), 1,
+            file) == 1
+        && readArray(file, mesh.getFlux().getValues(),
+                mesh.getFlux().getSize())
+        && readArray(file, mesh.getFluxSquared().getValues(),
+                mesh.getFluxSquared().getSize());
+    std::vector <double> cmfd_state;
+    read = read && readArray(file, cmfd_state)
+        && (cmfd == NULL || cmfd->setState(cmfd_state));
+    fclose(file);
+    if (!read) {
+        std::cout << "Checkpoint " << file_name << " is damaged or does not "
+            << "match the tallies, mesh and CMFD of this run" << std::endl;
+        return false;
+    }
+    mesh.setNumFluxBatches(num_flux_batches);
+    *batch = header[2];
+    if (header[3] > 0)
+        *first_active = header[3];
+    return true;
+}
+
+/*
+ @brief     loads only the fission bank of a checkpoint, to start a new run
+            from a converged source
+ @param     file_name the name of the checkpoint file
+ @param     fission_banks the fission bank to load the banked sites into
+ @return    true if the source was loaded
+*/
+bool readCheckpointSource(std::string file_name, Fission &fission_banks) {
+    FILE* file = fopen(file_name.c_str(), "rb");
+    if (file == NULL) {
+        std::cout << "Could not open checkpoint " << file_name << std::endl;
+        return false;
+    }
+    int32_t header[6];
+    bool read = readHeaderAndSource(file, header, fission_banks);
+    fclose(file);
+    if (!read) {
+        std::cout << "Checkpoint " << file_name << " is damaged"
+            << std::endl;
+    }
+    return read;
+}
@@ -0,0 +1,42 @@
+/*
+ @file      Checkpoint.h
+ @brief     functions for saving and resuming an eigenvalue run
+ @author    Luke Eure
+ @date      March 24 2016
+*/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "Tally.h"
+#include "Mesh.h"
+#include "Fission.h"
+#include "Cmfd.h"
+#include "Parallel.h"
+
+/** identifies a checkpoint file */
+const char CHECKPOINT_MAGIC[8] = {'M', 'G', 'M', 'C', 'C', 'H', 'K', 'P'};
+
+/** version of the checkpoint file format */
+const int32_t CHECKPOINT_VERSION = 2;
+
+void writeCheckpoint(std::string file_name, int n_histories, int batch,
+        int first_active, Fission &fission_banks,
+        std::vector <double> &entropies,
+        std::vector <std::vector <double> > &k_samples,
+        std::vector <Tally*> &tallies, Mesh &mesh, Cmfd* cmfd);
+bool readCheckpoint(std::string file_name, int n_histories, int* batch,
+        int* first_active, Fission &fission_banks,
+        std::vector <double> &entropies,
+        std::vector <std::vector <double> > &k_samples,
+        std::vector <Tally*> &tallies, Mesh &mesh, Cmfd* cmfd);
+bool readCheckpointSource(std::string file_name, Fission &fission_banks);
+
+#endif
@@ -0,0 +1,480 @@
+/*
+ @file      Cmfd.cpp
+ @brief     contains functions for the Cmfd class
+ @author    Luke Eure
+ @date      April 12 2016
+*/
+
+#include "Cmfd.h"
+
+/*
+ @brief     constructor for Cmfd class
+ @param     mesh the mesh whose cells are grouped into the coarse mesh
+ @param     bounds a Boundaries object containing the boundary conditions
+            of the bounding box
+ @param     x_cells the number of coarse cells along the x axis, at most
+            the number of mesh cells
+ @param     y_cells the number of coarse cells along the y axis
+ @param     z_cells the number of coarse cells along the z axis
+ @param     num_groups the number of neutron energy groups
+*/
+Cmfd::Cmfd(Mesh &mesh, Boundaries &bounds, int x_cells, int y_cells,
+        int z_cells, int num_groups) {
+    _num_groups = num_groups;
+    int divisions[3] = {x_cells, y_cells, z_cells};
+    buildCoarseMesh(mesh, divisions);
+    for (int axis=0; axis<3; ++axis) {
+        for (int side=MIN; side<=MAX; ++side) {
+            _reflective[axis][side] = bounds.getSurfaceType(axis, side)
+                == REFLECTIVE;
+        }
+    }
+
+    // lay out the values of each coarse cell and group
+    _scatter_value = 3;
+    _chi_value = _scatter_value + num_groups;
+    _current_value = _chi_value + num_groups;
+    int num_values = _current_value + 6;
+    _tally.addMeshFilter(_grid.getAxisSize(0), _grid.getAxisSize(1),
+            _grid.getAxisSize(2));
+    _tally.addGroupFilter(num_groups);
+    for (int v=0; v<num_values; ++v)
+        _tally.addScore(EVENT_SCORE);
+    _accumulated.assign(_tally.getSize(), 0.0);
+    _k = 1.0;
+}
+
+/*
+ @brief     deconstructor
+*/
+Cmfd::~Cmfd() {}
+
+/*
+ @brief     returns the tally the coarse mesh values are scored in, to be
+            run with the other tallies of a batch
+ @return    a pointer to the tally
+*/
+Tally* Cmfd::getTally() {
+    return &_tally;
+}
+
+/*
+ @brief     credits the coarse cell holding a mesh cell with an estimate of
+            the flux times each cross section
+ @param     tally a copy of the tally returned by getTally() to score in
+ @param     cell the mesh cell of the neutron
+ @param     group the energy group of the neutron
+ @param     material the material the flux was estimated in
+ @param     flux the estimate of the flux, a track length
+*/
+void Cmfd::score(Tally &tally, int* cell, int group, Material* material,
+        double flux) {
+    int coarse_cell[3];
+    getCoarseCell(cell, coarse_cell);
+    double* values = tally.getBatchValues()
+        + tally.getIndex(coarse_cell, group, NULL, 0);
+    double nu_sigma_f = material->getNu() * material->getSigmaF(group);
+    double* sigma_s = material->getSigmaS(group);
+    double* chi = material->getChi();
+    values[0] += flux;
+    values[1] += flux * material->getSigmaT(group);
+    values[2] += flux * nu_sigma_f;
+    for (int g=0; g<_num_groups; ++g) {
+        values[_scatter_value + g] += flux * sigma_s[g];
+        values[_chi_value + g] += flux * nu_sigma_f * chi[g];
+    }
+}
+
+/*
+ @brief     counts a neutron reaching a surface of its mesh cell in the net
+            current through the surface, if it is a face of the coarse mesh
+            and the neutron is not reflected
+ @param     tally a copy of the tally returned by getTally() to score in
+ @param     cell the mesh cell the neutron is leaving
+ @param     axis the axis normal to the surface
+ @param     side the side of the cell the surface is on
+ @param     group the energy group of the neutron
+ @param     weight the weight of the neutron
+*/
+void Cmfd::scoreCrossing(Tally &tally, int* cell, int axis, min_max side,
+        int group, double weight) {
+    int coarse_cell[3];
+    getCoarseCell(cell, coarse_cell);
+    double sign = side == MAX ? weight : -weight;
+    int last_cell = _coarse_cells[axis].size() - 1;
+
+    // a face on the edge of the mesh
+    if ((side == MIN && cell[axis] == 0)
+            || (side == MAX && cell[axis] == last_cell)) {
+        if (!_reflective[axis][side]) {
+            tally.add(tally.getIndex(coarse_cell, group, NULL,
+                        _current_value + 2 * axis + side), sign);
+        }
+        return;
+    }
+
+    // a face between coarse cells, kept on the cell below it
+    int neighbor = _coarse_cells[axis][cell[axis] + (side == MAX ? 1 : -1)];
+    if (neighbor == coarse_cell[axis])
+        return;
+    if (side == MIN)
+        coarse_cell[axis] = neighbor;
+    tally.add(tally.getIndex(coarse_cell, group, NULL,
+                _current_value + 2 * axis + MAX), sign);
+}
+
+/*
+ @brief     adds the values of the current batch, summed over threads and
+            processes, to those of earlier batches
+*/
+void Cmfd::accumulate() {
+    double* values = _tally.getBatchValues();
+    for (long i=0; i<_accumulated.size(); ++i)
+        _accumulated[i] += values[i];
+}
+
+/*
+ @brief     solves the coarse mesh diffusion eigenproblem built from the
+            accumulated values
+ @details   the cross sections of each coarse cell are the tallied reaction
+            rates over the tallied flux, and the diffusion coefficient is
+            1 / (3 sigma_t). The net current from cell i to its neighbour j
+            is -D~ (phi_j - phi_i) + D^ (phi_j + phi_i), where D~ is the
+            finite difference coupling and D^ makes the current equal the
+            tallied one; on the edge of the mesh the outgoing current is
+            the tallied one over phi_i. The eigenproblem is solved by power
+            iteration, sweeping each group with Gauss-Seidel iterations.
+ @return    true if the solve converged to a positive flux, in which case
+            getK() and reweightSites() use the new solution
+*/
+bool Cmfd::solve() {
+    int num_groups = _num_groups;
+    long num_cells = _grid.getNumCells();
+    int* sizes = _grid.getAxisSizes();
+    long strides[3] = {(long) sizes[1] * sizes[2], sizes[2], 1};
+    _diagonal.assign(num_cells * num_groups, 0.0);
+    _coupling.assign(num_cells * num_groups * 6, 0.0);
+    _scatter.assign(num_cells * num_groups * num_groups, 0.0);
+    _chi_nu_fission.assign(num_cells * num_groups * num_groups, 0.0);
+    _nu_fission.assign(num_cells * num_groups, 0.0);
+    std::vector <double> flux(num_cells * num_groups);
+    std::vector <double> diffusion(num_cells * num_groups);
+    std::vector <double> volumes(num_cells);
+
+    // cross sections of every coarse cell, which must all have been reached
+    int coarse_cell[3];
+    for (coarse_cell[0]=0; coarse_cell[0]<sizes[0]; ++coarse_cell[0]) {
+    for (coarse_cell[1]=0; coarse_cell[1]<sizes[1]; ++coarse_cell[1]) {
+    for (coarse_cell[2]=0; coarse_cell[2]<sizes[2]; ++coarse_cell[2]) {
+        long c = getCoarseIndex(coarse_cell);
+        double volume = 1.0;
+        for (int axis=0; axis<3; ++axis) {
+            volume *= _grid.getPlane(axis, coarse_cell[axis] + 1)
+                - _grid.getPlane(axis, coarse_cell[axis]);
+        }
+        volumes[c] = volume;
+        for (int g=0; g<num_groups; ++g) {
+            double* values = &_accumulated[_tally.getIndex(coarse_cell, g,
+                    NULL, 0)];
+            double tally_flux = values[0];
+            if (tally_flux <= 0.0)
+                return false;
+            long i = c * num_groups + g;
+            flux[i] = tally_flux / volume;
+            diffusion[i] = tally_flux / (3.0 * values[1]);
+            _diagonal[i] = volume * values[1] / tally_flux;
+            _nu_fission[i] = volume * values[2] / tally_flux;
+            for (int to=0; to<num_groups; ++to) {
+                _scatter[i * num_groups + to] = volume
+                    * values[_scatter_value + to] / tally_flux;
+                _chi_nu_fission[i * num_groups + to] = volume
+                    * values[_chi_value + to] / tally_flux;
+            }
+            _diagonal[i] -= _scatter[i * num_groups + g];
+        }
+    }
+    }
+    }
+
+    // couple each cell to its neighbours through its faces
+    for (coarse_cell[0]=0; coarse_cell[0]<sizes[0]; ++coarse_cell[0]) {
+    for (coarse_cell[1]=0; coarse_cell[1]<sizes[1]; ++coarse_cell[1]) {
+    for (coarse_cell[2]=0; coarse_cell[2]<sizes[2]; ++coarse_cell[2]) {
+        long c = getCoarseIndex(coarse_cell);
+        for (int axis=0; axis<3; ++axis) {
+            int index = coarse_cell[axis];
+            double width = _grid.getPlane(axis, index + 1)
+                - _grid.getPlane(axis, index);
+            double area = volumes[c] / width;
+            for (int g=0; g<num_groups; ++g) {
+                long i = c * num_groups + g;
+                double* values = &_accumulated[_tally.getIndex(coarse_cell,
+                        g, NULL, 0)];
+                double current = values[_current_value + 2 * axis + MAX]
+                    / area;
+
+                // faces on the edge of the mesh, with outgoing currents
+                if (index == 0) {
+                    _diagonal[i] -= values[_current_value + 2 * axis + MIN]
+                        / flux[i];
+                }
+                if (index == sizes[axis] - 1) {
+                    _diagonal[i] += area * current / flux[i];
+                    continue;
+                }
+
+                // the face shared with the cell above
+                long j = (c + strides[axis]) * num_groups + g;
+                double neighbor_width = _grid.getPlane(axis, index + 2)
+                    - _grid.getPlane(axis, index + 1);
+                double d_tilde = 2.0 * diffusion[i] * diffusion[j]
+                    / (diffusion[i] * neighbor_width
+                            + diffusion[j] * width);
+                double d_hat = (current + d_tilde * (flux[j] - flux[i]))
+                    / (flux[j] + flux[i]);
+                _diagonal[i] += area * (d_tilde + d_hat);
+                _coupling[i * 6 + 2 * axis + MAX] = area * (d_hat - d_tilde);
+                _diagonal[j] += area * (d_tilde - d_hat);
+                _coupling[j * 6 + 2 * axis + MIN] = -area * (d_tilde + d_hat);
+            }
+        }
+    }
+    }
+    }
+    for (long i=0; i<_diagonal.size(); ++i) {
+        if (_diagonal[i] <= 0.0)
+            return false;
+    }
+
+    // power iteration from the tallied flux
+    double k = _k;
+    std::vector <double> source(num_cells);
+    std::vector <double> fission_source(num_cells);
+    std::vector <double> old_fission_source(num_cells, 0.0);
+    double production = 0.0;
+    for (long i=0; i<flux.size(); ++i)
+        production += _nu_fission[i] * flux[i];
+    bool converged = false;
+    for (int iteration=0; iteration<CMFD_MAX_OUTER_ITERATIONS && !converged;
+            ++iteration) {
+
+        // sweep each group with its fission and in-scatter source
+        for (int g=0; g<num_groups; ++g) {
+            for (long c=0; c<num_cells; ++c) {
+                source[c] = 0.0;
+                for (int from=0; from<num_groups; ++from) {
+                    long i = c * num_groups + from;
+                    double cross_section = _chi_nu_fission[i * num_groups + g]
+                        / k;
+                    if (from != g)
+                        cross_section += _scatter[i * num_groups + g];
+                    source[c] += cross_section * flux[i];
+                }
+            }
+            sweepGroup(g, flux, source);
+        }
+
+        // update k and compare the fission source with the last one
+        double new_production = 0.0;
+        for (long c=0; c<num_cells; ++c) {
+            fission_source[c] = 0.0;
+            for (int g=0; g<num_groups; ++g) {
+                long i = c * num_groups + g;
+                fission_source[c] += _nu_fission[i] * flux[i];
+            }
+            new_production += fission_source[c];
+        }
+        if (new_production <= 0.0)
+            return false;
+        double new_k = k * new_production / production;
+        double source_change = 0.0;
+        for (long c=0; c<num_cells; ++c) {
+            fission_source[c] /= new_production;
+            if (fission_source[c] > 0.0) {
+                source_change = std::max(source_change, fabs(fission_source[c]
+                            - old_fission_source[c]) / fission_source[c]);
+            }
+        }
+        converged = fabs(new_k - k) < CMFD_TOLERANCE * new_k
+            && source_change < CMFD_TOLERANCE;
+        k = new_k;
+        production = new_production;
+        old_fission_source.swap(fission_source);
+    }
+    if (!converged)
+        return false;
+    for (long i=0; i<flux.size(); ++i) {
+        if (flux[i] < 0.0)
+            return false;
+    }
+    _k = k;
+    _fission_source.swap(old_fission_source);
+    return true;
+}
+
+/*
+ @brief     copies out what the coarse mesh carries from batch to batch, so
+            a run can be checkpointed
+ @param     state filled with k of the last solve, then the values summed
+            over the batches accumulated so far
+*/
+void Cmfd::getState(std::vector <double> &state) {
+    state.assign(1, _k);
+    state.insert(state.end(), _accumulated.begin(), _accumulated.end());
+}
+
+/*
+ @brief     restores what the coarse mesh carries from batch to batch from a
+            checkpoint
+ @param     state the values filled by getState()
+ @return    true if the state is the size of this coarse mesh's
+*/
+bool Cmfd::setState(std::vector <double> &state) {
+    if (state.size() != _accumulated.size() + 1)
+        return false;
+    _k = state[0];
+    _accumulated.assign(state.begin() + 1, state.end());
+    return true;
+}
+
+/*
+ @brief     returns k of the coarse mesh eigenproblem
+ @return    k from the last successful solve
+*/
+double Cmfd::getK() {
+    return _k;
+}
+
+/*
+ @brief     reweights fission sites so the weight banked in each coarse
+            cell is in proportion to the fission source of the last solve,
+            keeping the total weight
+ @param     sites this rank's piece of the fission bank, SITE_SIZE values
+            per site
+*/
+void Cmfd::reweightSites(std::vector <double> &sites) {
+    long num_cells = _grid.getNumCells();
+    if (_fission_source.size() != num_cells)
+        return;
+
+    // weight banked in each coarse cell over all ranks
+    std::vector <double> weights(num_cells, 0.0);
+    std::vector <long> site_cells(sites.size() / SITE_SIZE);
+    for (long s=0; s<site_cells.size(); ++s) {
+        int coarse_cell[3];
+        for (int axis=0; axis<3; ++axis) {
+            coarse_cell[axis] = _grid.findCell(axis,
+                    sites[s * SITE_SIZE + axis]);
+        }
+        site_cells[s] = getCoarseIndex(coarse_cell);
+        weights[site_cells[s]] += sites[s * SITE_SIZE + SITE_SIZE - 1];
+    }
+    reduceValues(weights);
+
+    // scale each cell's weight to its share of the coarse fission source
+    double total_weight = 0.0;
+    for (long c=0; c<num_cells; ++c)
+        total_weight += weights[c];
+    std::vector <double> factors(num_cells, 1.0);
+    double new_weight = 0.0;
+    for (long c=0; c<num_cells; ++c) {
+        if (weights[c] > 0.0) {
+            factors[c] = _fission_source[c] * total_weight / weights[c];
+            new_weight += factors[c] * weights[c];
+        }
+    }
+    if (new_weight <= 0.0)
+        return;
+    for (long s=0; s<site_cells.size(); ++s) {
+        sites[s * SITE_SIZE + SITE_SIZE - 1] *= factors[site_cells[s]]
+            * total_weight / new_weight;
+    }
+}
+
+/*
+ @brief     finds the index of a coarse cell in arrays over all coarse cells
+ @param     coarse_cell the coarse cell number along each axis
+ @return    the coarse cell index
+*/
+long Cmfd::getCoarseIndex(int* coarse_cell) {
+    return _grid.getCellIndex(coarse_cell);
+}
+
+/*
+ @brief     finds the coarse cell holding a mesh cell
+ @param     cell the mesh cell number along each axis
+ @param     coarse_cell an array of three ints to fill with the coarse cell
+            number along each axis
+*/
+void Cmfd::getCoarseCell(int* cell, int* coarse_cell) {
+    for (int axis=0; axis<3; ++axis)
+        coarse_cell[axis] = _coarse_cells[axis][cell[axis]];
+}
+
+/*
+ @brief     groups the cells of the mesh into the coarse mesh, as evenly as
+            the mesh planes allow
+ @param     mesh the mesh
+ @param     divisions the number of coarse cells along each axis
+*/
+void Cmfd::buildCoarseMesh(Mesh &mesh, int* divisions) {
+    std::vector <std::vector <double> > planes(3);
+    for (int axis=0; axis<3; ++axis) {
+        int num_cells = mesh.getAxisSize(axis);
+        int num_coarse = std::max(1, std::min(divisions[axis], num_cells));
+        if (num_coarse != divisions[axis]) {
+            std::cout << "Using " << num_coarse << " CMFD cells along axis "
+                << axis << std::endl;
+        }
+        _coarse_cells[axis].resize(num_cells);
+        for (int i=0; i<num_cells; ++i) {
+            _coarse_cells[axis][i] = (long) i * num_coarse / num_cells;
+            if (i == 0 || _coarse_cells[axis][i] != _coarse_cells[axis][i-1])
+                planes[axis].push_back(mesh.getPlane(axis, i));
+        }
+        planes[axis].push_back(mesh.getPlane(axis, num_cells));
+    }
+    _grid = Grid(planes);
+}
+
+/*
+ @brief     runs Gauss-Seidel sweeps over the coarse cells for the flux of
+            one group until it stops changing
+ @param     group the energy group
+ @param     flux the flux of every coarse cell and group, updated in place
+ @param     source the source of each coarse cell in the group
+*/
+void Cmfd::sweepGroup(int group, std::vector <double> &flux,
+        std::vector <double> &source) {
+    int num_groups = _num_groups;
+    long num_cells = source.size();
+    int* sizes = _grid.getAxisSizes();
+    long strides[3] = {(long) sizes[1] * sizes[2], sizes[2], 1};
+    for (int sweep=0; sweep<CMFD_MAX_INNER_ITERATIONS; ++sweep) {
+        double change = 0.0;
+        for (long c=0; c<num_cells; ++c) {
+            long i = c * num_groups + group;
+            double* coupling = &_coupling[i * 6];
+            double sum = source[c];
+
+            // neighbours off the edge of the mesh have no coupling
+            for (int axis=0; axis<3; ++axis) {
+                if (coupling[2 * axis + MIN] != 0.0) {
+                    sum -= coupling[2 * axis + MIN]
+                        * flux[i - strides[axis] * num_groups];
+                }
+                if (coupling[2 * axis + MAX] != 0.0) {
+                    sum -= coupling[2 * axis + MAX]
+                        * flux[i + strides[axis] * num_groups];
+                }
+            }
+            double new_flux = sum / _diagonal[i];
+            if (new_flux != 0.0)
+                change = std::max(change, fabs(new_flux - flux[i])
+                        / fabs(new_flux));
+            flux[i] = new_flux;
+        }
+        if (change < CMFD_TOLERANCE)
+            return;
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ @file      Cmfd.h
+ @brief     contains the Cmfd class
+ @author    Luke Eure
+ @date      April 12 2016
+*/
+
+#ifndef CMFD_H
+#define CMFD_H
+
+#include <iostream>
+#include <vector>
+#include <math.h>
+
+#include "Tally.h"
+#include "Mesh.h"
+#include "Grid.h"
+#include "Boundaries.h"
+#include "Fission.h"
+#include "Parallel.h"
+
+/** largest number of power iterations of the coarse mesh eigenproblem */
+const int CMFD_MAX_OUTER_ITERATIONS = 10000;
+
+/** largest number of Gauss-Seidel sweeps of one group per power iteration */
+const int CMFD_MAX_INNER_ITERATIONS = 20;
+
+/** relative change in k and the fission source below which the coarse mesh
+    eigenproblem has converged */
+const double CMFD_TOLERANCE = 1e-8;
+
+/*
+ @brief     coarse mesh finite difference acceleration of the fission source
+ @details   cells of the Mesh are grouped into a coarse mesh, and each batch
+            the coarse cell reaction rates and the net currents through the
+            coarse faces are tallied. From the tallies of all batches so far
+            a diffusion eigenproblem is built whose coupling coefficients
+            are corrected so it reproduces the tallied currents exactly, and
+            its fission source is used to reweight the fission bank. The
+            coarse problem converges in a fraction of a second, pulling the
+            Monte Carlo source toward its converged shape in far fewer
+            batches than power iteration alone. Scoring relies on the
+            neutron crossing mesh cell surfaces, so it needs surface
+            tracking through the mesh.
+*/
+class Cmfd {
+
+public:
+    Cmfd(Mesh &mesh, Boundaries &bounds, int x_cells, int y_cells,
+            int z_cells, int num_groups);
+    virtual ~Cmfd();
+
+    Tally* getTally();
+    void score(Tally &tally, int* cell, int group, Material* material,
+            double flux);
+    void scoreCrossing(Tally &tally, int* cell, int axis, min_max side,
+            int group, double weight);
+    void accumulate();
+    bool solve();
+    double getK();
+    void reweightSites(std::vector <double> &sites);
+    void getState(std::vector <double> &state);
+    bool setState(std::vector <double> &state);
+
+private:
+    long getCoarseIndex(int* coarse_cell);
+    void getCoarseCell(int* cell, int* coarse_cell);
+    void buildCoarseMesh(Mesh &mesh, int* divisions);
+    void sweepGroup(int group, std::vector <double> &flux,
+            std::vector <double> &source);
+
+    /** number of neutron energy groups */
+    int _num_groups;
+
+    /** the planes of the coarse mesh, all planes of the Mesh */
+    Grid _grid;
+
+    /** the coarse cell holding each mesh cell along each axis */
+    std::vector <int> _coarse_cells[3];
+
+    /** whether each face of the bounding box is reflective, indexed by
+        axis then side */
+    bool _reflective[3][2];
+
+    /** position of each value in a coarse cell and group of the tally:
+        the flux, total and nu-fission rates, the scattering rate into each
+        group, the fission rate into each group weighted by chi, then the
+        net current in the positive direction through the lower and upper
+        face along each axis. Lower face currents are only kept on the
+        edges of the mesh. */
+    int _scatter_value;
+    int _chi_value;
+    int _current_value;
+
+    /** the values scored in the current batch */
+    Tally _tally;
+
+    /** the values summed over the batches accumulated so far */
+    std::vector <double> _accumulated;
+
+    /** the loss operator of each coarse cell and group: the diagonal, and
+        the coupling to the neighbour below and above along each axis */
+    std::vector <double> _diagonal;
+    std::vector <double> _coupling;
+
+    /** scattering and chi-weighted nu-fission cross sections of each
+        coarse cell from each group into each group, times the cell volume */
+    std::vector <double> _scatter;
+    std::vector <double> _chi_nu_fission;
+
+    /** nu-fission cross section of each coarse cell and group times the
+        cell volume */
+    std::vector <double> _nu_fission;
+
+    /** k and the normalized fission source of each coarse cell from the
+        last solve */
+    double _k;
+    std::vector <double> _fission_source;
+};
+
+#endif
@@ -0,0 +1,214 @@
+/*
+ @file      Fission.cpp
+ @brief     contains functions for the Fission class
+ @author    Luke Eure
+ @date      February 10 2016
+*/
+
+#include "Fission.h"
+
+/*
+ @brief     constructor for Fission class
+ @param     capacity the number of sites to allocate room for in each bank,
+            so banking sites does not reallocate
+*/
+Fission::Fission(long capacity) {
+    _new_sites.reserve(capacity * SITE_SIZE);
+    _old_sites.reserve(capacity * SITE_SIZE);
+    _received_sites.reserve(capacity * SITE_SIZE);
+    _first_history = -1;
+}
+
+/*
+ @brief     deconstructor
+*/
+Fission::~Fission() {}
+
+/*
+ @brief     adds a site to the bank of the current batch
+ @param     site an array of SITE_SIZE values: the position of the site and
+            its weight
+*/
+void Fission::add(double* site) {
+    _new_sites.insert(_new_sites.end(), site, site + SITE_SIZE);
+}
+
+/*
+ @brief     makes the sites banked in the last batch the source of the next
+            one, spread evenly over the processes, with each neutron drawing
+            its site at random
+*/
+void Fission::newBatch() {
+    balanceSites(_new_sites, SITE_SIZE, _received_sites);
+    _old_sites.swap(_new_sites);
+    _new_sites.clear();
+    _first_history = -1;
+}
+
+/*
+ @brief     resamples the sites banked in the last batch into a source of
+            exactly n_histories sites by combing
+ @details   the sites are laid end to end with lengths equal to their
+            weights, and a comb of n_histories evenly spaced teeth with a
+            random offset is dropped on them; each tooth selects the site it
+            lands in. Sites are selected in proportion to their weight and
+            the source size no longer follows k. Each rank combs its own
+            piece of the bank, then gathers the source sites of its
+            histories. The combed sites have unit weight.
+ @param     n_histories the number of histories in the next batch
+ @param     first_history the first history run by this rank
+ @param     last_history one past the last history run by this rank
+ @param     stream the random number stream used to place the comb, the same
+            on every rank
+*/
+void Fission::newBatch(int n_histories, int first_history, int last_history,
+        RandomStream &stream) {
+    
+    // total weight banked, and the weight banked before this rank's piece
+    double weight = 0.0;
+    for (long i=0; i<_new_sites.size(); i+=SITE_SIZE)
+        weight += _new_sites[i + SITE_SIZE - 1];
+    double total_weight;
+    double weight_offset = getWeightOffset(weight, &total_weight);
+    double offset = stream.arand();
+    if (total_weight <= 0.0) {
+        if (getGlobalSize() > 0 && getRank() == 0) {
+            std::cout << "No fission sites banked, reusing the last source"
+                << std::endl;
+        }
+        _new_sites.clear();
+        return;
+    }
+    double spacing = total_weight / n_histories;
+
+    // first tooth at or past the start of this rank's piece
+    long tooth = (long) ceil(weight_offset / spacing - offset);
+    if (tooth < 0)
+        tooth = 0;
+
+    // select a site for each tooth landing in this rank's piece
+    _old_sites.clear();
+    double cumulative_weight = weight_offset;
+    for (long i=0; i<_new_sites.size(); i+=SITE_SIZE) {
+        cumulative_weight += _new_sites[i + SITE_SIZE - 1];
+        while (tooth < n_histories
+                && (tooth + offset) * spacing < cumulative_weight) {
+            _old_sites.insert(_old_sites.end(), &_new_sites[i],
+                    &_new_sites[i] + SITE_SIZE);
+            _old_sites.back() = 1.0;
+            tooth++;
+        }
+    }
+
+    // roundoff can leave the last teeth just past the end of the last piece
+    if (_new_sites.size() > 0 && weight_offset + weight
+            >= total_weight * (1.0 - 1e-12)) {
+        while (tooth < n_histories) {
+            _old_sites.insert(_old_sites.end(),
+                    _new_sites.end() - SITE_SIZE, _new_sites.end());
+            _old_sites.back() = 1.0;
+            tooth++;
+        }
+    }
+
+    // gather the source sites of this rank's histories
+    redistributeSites(_old_sites, SITE_SIZE, first_history, last_history,
+            _received_sites);
+    _new_sites.clear();
+    _first_history = first_history;
+}
+
+/*
+ @brief     samples the source site of a neutron from the bank
+ @param     neutron the neutron to be born; its history picks its site if
+            the source was combed, otherwise its random number stream does
+ @param     position an array of three coordinates to fill with the site
+ @return    false, leaving position unset, if this rank holds no sites
+*/
+bool Fission::sampleSite(Neutron* neutron, double* position) {
+    if (size() == 0)
+        return false;
+    long index;
+    if (_first_history >= 0)
+        index = neutron->getId() - _first_history;
+    else
+        index = neutron->rand() % size();
+    for (int axis=0; axis<3; ++axis)
+        position[axis] = _old_sites[index * SITE_SIZE + axis];
+    return true;
+}
+
+/*
+ @brief     returns the number of source sites held by this rank
+ @return    the number of sites in the old bank
+*/
+long Fission::size() {
+    return _old_sites.size() / SITE_SIZE;
+}
+
+/*
+ @brief     returns the number of source sites held by all processes
+ @return    the number of sites in the old bank of every rank
+*/
+long Fission::getGlobalSize() {
+    return getGlobalSiteCount(_old_sites, SITE_SIZE);
+}
+
+/*
+ @brief     returns the sites banked in the current batch, SITE_SIZE values
+            per site, used to save and restore the bank
+ @return    this rank's piece of the new bank
+*/
+std::vector <double>& Fission::getBankedSites() {
+    return _new_sites;
+}
+
+/*
+ @brief     computes the Shannon entropy of the sites banked in the current
+            batch over a coarse mesh superimposed on the bounding box
+ @details   the entropy -sum p log2(p) of the fraction p of the banked
+            weight in each mesh cell settles as the fission source
+            converges. Sites outside the box are counted in the nearest
+            cell.
+ @param     bounds a Boundaries object containing the limits of the
+            bounding box
+ @param     divisions an array of the number of mesh divisions along each
+            axis
+ @return    the entropy of the fission source over all ranks, in bits
+*/
+double Fission::getEntropy(Boundaries &bounds, int* divisions) {
+    double box_min[3];
+    double width[3];
+    for (int axis=0; axis<3; ++axis) {
+        box_min[axis] = bounds.getSurfaceCoord(axis, MIN);
+        width[axis] = (bounds.getSurfaceCoord(axis, MAX) - box_min[axis])
+            / divisions[axis];
+    }
+
+    // sum the weight banked in each cell of the entropy mesh
+    std::vector <double> cell_weights(divisions[0] * divisions[1]
+            * divisions[2], 0.0);
+    for (long i=0; i<_new_sites.size(); i+=SITE_SIZE) {
+        long cell = 0;
+        for (int axis=0; axis<3; ++axis) {
+            int index = (int) floor((_new_sites[i + axis] - box_min[axis])
+                    / width[axis]);
+            index = std::max(0, std::min(index, divisions[axis] - 1));
+            cell = cell * divisions[axis] + index;
+        }
+        cell_weights[cell] += _new_sites[i + SITE_SIZE - 1];
+    }
+    reduceValues(cell_weights);
+
+    double total_weight = 0.0;
+    for (long cell=0; cell<cell_weights.size(); ++cell)
+        total_weight += cell_weights[cell];
+    double entropy = 0.0;
+    for (long cell=0; cell<cell_weights.size(); ++cell) {
+        if (cell_weights[cell] > 0.0) {
+            double fraction = cell_weights[cell] / total_weight;
+            entropy -= fraction * log2(fraction);
+        }
+    }
+    return entropy;
+}
@@ -0,0 +1,64 @@
+/*
+ @file      Fission.h
+ @brief     contains the Fission class
+ @author    Luke Eure
+ @date      February 10 2016
+*/
+
+#ifndef FISSION_H
+#define FISSION_H
+
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <math.h>
+
+#include "Neutron.h"
+#include "Random_stream.h"
+#include "Boundaries.h"
+#include "Parallel.h"
+
+/** number of values stored for each fission site: x, y, z and weight */
+const int SITE_SIZE = 4;
+
+/*
+ @brief     holds the fission sites banked in the current batch and the
+            source sites of the next batch
+ @details   sites are stored as flat arrays of SITE_SIZE values. With MPI
+            each rank holds a contiguous piece of the global bank.
+*/
+class Fission {
+
+public:
+    Fission(long capacity);
+    virtual ~Fission();
+
+    void add(double* site);
+    void newBatch();
+    void newBatch(int n_histories, int first_history, int last_history,
+            RandomStream &stream);
+    bool sampleSite(Neutron* neutron, double* position);
+    long size();
+    long getGlobalSize();
+    std::vector <double>& getBankedSites();
+    double getEntropy(Boundaries &bounds, int* divisions);
+
+private:
+
+    /** sites banked during the current batch */
+    std::vector <double> _new_sites;
+
+    /** source sites of the current batch */
+    std::vector <double> _old_sites;
+
+    /** scratch buffer for sites moved between processes, swapped with the
+        bank they are gathered into */
+    std::vector <double> _received_sites;
+
+    /** first history of this rank if the source was combed, in which case
+        history i starts at source site i - _first_history, or -1 if sites
+        are sampled at random */
+    int _first_history;
+};
+
+#endif
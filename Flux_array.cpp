@@ -0,0 +1,216 @@
+/*
+ @file      Flux_array.cpp
+ @brief     contains functions for the FluxView and FluxArray classes
+ @author    Luke Eure
+ @date      March 21 2016
+*/
+
+#include "Flux_array.h"
+
+/*
+ @brief     constructor for an empty FluxView
+*/
+FluxView::FluxView() {
+    _values = NULL;
+    for (int axis=0; axis<3; ++axis)
+        _axis_sizes[axis] = 0;
+    _num_cells = 0;
+    _num_groups = 0;
+    _layout = GROUP_OUTER;
+}
+
+/*
+ @brief     constructor for FluxView class
+ @param     values the flux values, stored contiguously
+ @param     axis_sizes the number of cells along each axis
+ @param     num_groups the number of energy groups
+ @param     layout the order the values are stored in
+*/
+FluxView::FluxView(double* values, int* axis_sizes, int num_groups,
+        FluxLayout layout) {
+    _values = values;
+    for (int axis=0; axis<3; ++axis)
+        _axis_sizes[axis] = axis_sizes[axis];
+    _num_cells = (long) axis_sizes[0] * axis_sizes[1] * axis_sizes[2];
+    _num_groups = num_groups;
+    _layout = layout;
+}
+
+/*
+ @brief     deconstructor
+*/
+FluxView::~FluxView() {}
+
+/*
+ @brief     finds where the flux of a cell and group is stored
+ @param     cell an array of the cell number along each axis
+ @param     group the energy group
+ @return    the index of the value in the buffer
+*/
+long FluxView::getIndex(int* cell, int group) {
+    long cell_index = ((long) cell[0] * _axis_sizes[1] + cell[1])
+        * _axis_sizes[2] + cell[2];
+    if (_layout == GROUP_OUTER)
+        return group * _num_cells + cell_index;
+    return cell_index * _num_groups + group;
+}
+
+/*
+ @brief     returns the flux of a cell and group
+ @param     cell an array of the cell number along each axis
+ @param     group the energy group
+ @return    the flux
+*/
+double FluxView::getValue(int* cell, int group) {
+    return _values[getIndex(cell, group)];
+}
+
+/*
+ @brief     returns the flux buffer
+ @return    a pointer to the first of getSize() contiguous values
+*/
+double* FluxView::getValues() {
+    return _values;
+}
+
+/*
+ @brief     returns the number of flux values
+ @return    the number of cells times the number of groups
+*/
+long FluxView::getSize() {
+    return _num_cells * _num_groups;
+}
+
+/*
+ @brief     returns the number of cells
+ @return    the number of cells
+*/
+long FluxView::getNumCells() {
+    return _num_cells;
+}
+
+/*
+ @brief     returns the number of energy groups
+ @return    the number of groups
+*/
+int FluxView::getNumGroups() {
+    return _num_groups;
+}
+
+/*
+ @brief     returns the number of cells along an axis
+ @param     axis 0, 1 or 2 for x, y and z
+ @return    the number of cells
+*/
+int FluxView::getAxisSize(int axis) {
+    return _axis_sizes[axis];
+}
+
+/*
+ @brief     returns the order the values are stored in
+ @return    the layout
+*/
+FluxLayout FluxView::getLayout() {
+    return _layout;
+}
+
+/*
+ @brief     constructor for an empty FluxArray
+*/
+FluxArray::FluxArray() : FluxView() {}
+
+/*
+ @brief     constructor for FluxArray class, with every value zero
+ @param     axis_sizes the number of cells along each axis
+ @param     num_groups the number of energy groups
+ @param     layout the order the values are stored in
+*/
+FluxArray::FluxArray(int* axis_sizes, int num_groups, FluxLayout layout)
+        : FluxView(NULL, axis_sizes, num_groups, layout) {
+    allocate();
+    clear();
+}
+
+/*
+ @brief     constructor copying the shape and values of a view
+ @param     flux the flux to copy
+*/
+FluxArray::FluxArray(FluxView flux) : FluxView(flux) {
+    allocate();
+    memcpy(_values, flux.getValues(), getSize() * sizeof(double));
+}
+
+/*
+ @brief     copy constructor
+ @param     flux the flux array to copy
+*/
+FluxArray::FluxArray(const FluxArray &flux) : FluxView(flux) {
+    allocate();
+    memcpy(_values, flux._values, getSize() * sizeof(double));
+}
+
+/*
+ @brief     copies the shape and values of another flux array
+ @param     flux the flux array to copy
+ @return    this flux array
+*/
+FluxArray& FluxArray::operator=(const FluxArray &flux) {
+    if (this != &flux) {
+        free(_values);
+        FluxView::operator=(flux);
+        allocate();
+        memcpy(_values, flux._values, getSize() * sizeof(double));
+    }
+    return *this;
+}
+
+/*
+ @brief     deconstructor, frees the buffer
+*/
+FluxArray::~FluxArray() {
+    free(_values);
+}
+
+/*
+ @brief     adds to the flux of a cell and group
+ @param     cell an array of the cell number along each axis
+ @param     group the energy group
+ @param     value the amount to add
+*/
+void FluxArray::add(int* cell, int group, double value) {
+    _values[getIndex(cell, group)] += value;
+}
+
+/*
+ @brief     adds another flux of the same shape and layout to this one
+ @param     flux the flux to add
+*/
+void FluxArray::add(FluxView &flux) {
+    double* values = flux.getValues();
+    long size = getSize();
+    #pragma omp simd
+    for (long i=0; i<size; ++i)
+        _values[i] += values[i];
+}
+
+/*
+ @brief     sets every value to zero
+*/
+void FluxArray::clear() {
+    if (getSize() > 0)
+        memset(_values, 0, getSize() * sizeof(double));
+}
+
+/*
+ @brief     allocates an aligned buffer for getSize() values
+*/
+void FluxArray::allocate() {
+    _values = NULL;
+    if (getSize() == 0)
+        return;
+    void* buffer;
+    if (posix_memalign(&buffer, FLUX_ALIGNMENT, getSize() * sizeof(double))
+            != 0)
+        throw std::bad_alloc();
+    _values = (double*) buffer;
+}
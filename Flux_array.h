@@ -0,0 +1,88 @@
+/*
+ @file      Flux_array.h
+ @brief     contains the FluxView and FluxArray classes
+ @author    Luke Eure
+ @date      March 21 2016
+*/
+
+#ifndef FLUX_ARRAY_H
+#define FLUX_ARRAY_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+/** alignment of flux buffers in bytes, one cache line */
+const int FLUX_ALIGNMENT = 64;
+
+// orders in which the values of a flux array are stored
+enum FluxLayout {
+    GROUP_OUTER,
+    GROUP_INNER
+};
+
+/*
+ @brief     a non-owning view of the flux in every cell and group of a mesh
+ @details   the flux is stored in one contiguous buffer. Cells are numbered
+            (i * y_cells + j) * z_cells + k. With GROUP_OUTER each group's
+            cells are stored together, value g * num_cells + cell, and with
+            GROUP_INNER each cell's groups are, value cell * num_groups + g.
+            Copying a view copies no flux.
+*/
+class FluxView {
+
+public:
+    FluxView();
+    FluxView(double* values, int* axis_sizes, int num_groups,
+            FluxLayout layout);
+    virtual ~FluxView();
+
+    long getIndex(int* cell, int group);
+    double getValue(int* cell, int group);
+    double* getValues();
+    long getSize();
+    long getNumCells();
+    int getNumGroups();
+    int getAxisSize(int axis);
+    FluxLayout getLayout();
+
+protected:
+
+    /** the flux values */
+    double* _values;
+
+    /** the number of cells along each axis */
+    int _axis_sizes[3];
+
+    /** the number of cells */
+    long _num_cells;
+
+    /** the number of energy groups */
+    int _num_groups;
+
+    /** the order the values are stored in */
+    FluxLayout _layout;
+};
+
+/*
+ @brief     a flux array owning an aligned buffer of its values
+*/
+class FluxArray : public FluxView {
+
+public:
+    FluxArray();
+    FluxArray(int* axis_sizes, int num_groups, FluxLayout layout);
+    FluxArray(FluxView flux);
+    FluxArray(const FluxArray &flux);
+    FluxArray& operator=(const FluxArray &flux);
+    virtual ~FluxArray();
+
+    void add(int* cell, int group, double value);
+    void add(FluxView &flux);
+    void clear();
+
+private:
+    void allocate();
+};
+
+#endif
@@ -1,17 +1,63 @@
 '''
  @file      Flux_parser.py
- @brief     Parses flux data from a text file
+ @brief     Reads flux data from a binary flux file
             and plots it as a heat map
  @author    Luke Eure
  @date      February 3, 2016
 '''
+import sys
 import numpy as np
 import matplotlib.pyplot as plt
 
-num_groups = 2;
-x_cells = 9;
-y_cells = 9;
-z_cells = 9;
+# header written by writeFluxToFile() in Plotter.cpp
+header_type = np.dtype([
+    ('magic', 'S8'),
+    ('version', 'i4'),
+    ('header_size', 'i4'),
+    ('num_groups', 'i4'),
+    ('cells', 'i4', 3),
+    ('layout', 'i4'),
+    ('num_batches', 'i4'),
+    ('origin', 'f8', 3),
+    ('delta', 'f8', 3)])
+
+GROUP_INNER = 1
+
+# size of the fixed part of the header, after which the grid planes follow
+FIXED_HEADER_SIZE = 128
+
+
+'''
+ @brief     Maps the mean flux and its standard deviation from a binary
+            flux file without reading them into memory
+ @param     file_name the name of the flux file
+ @return    the header, the grid planes along x, y and z, and the mean and
+            standard deviation of the flux as arrays indexed
+            [group, x, y, z]
+'''
+def read_flux(file_name):
+    header = np.fromfile(file_name, dtype=header_type, count=1)[0]
+    if header['magic'] != b'MGMCFLUX':
+        raise ValueError(file_name + ' is not a flux file')
+
+    num_groups = int(header['num_groups'])
+    cells = tuple(int(n) for n in header['cells'])
+    plane_values = np.fromfile(file_name, dtype='f8', count=sum(cells) + 3,
+            offset=FIXED_HEADER_SIZE)
+    planes = np.split(plane_values, np.cumsum([n + 1 for n in cells[:2]]))
+    if header['layout'] == GROUP_INNER:
+        shape = cells + (num_groups,)
+    else:
+        shape = (num_groups,) + cells
+    size = int(np.prod(shape))
+    values = np.memmap(file_name, dtype='f8', mode='r',
+            offset=int(header['header_size']), shape=(2, size))
+    mean = values[0].reshape(shape)
+    deviation = values[1].reshape(shape)
+    if header['layout'] == GROUP_INNER:
+        mean = np.moveaxis(mean, -1, 0)
+        deviation = np.moveaxis(deviation, -1, 0)
+    return header, planes, mean, deviation
 
 
 '''
@@ -38,22 +84,11 @@ def plot_heat_map(flux_data, index, repeat = 100, title=''):
     plt.title(title)
     plt.show(title)
 
-with open('flux_plot.txt', 'r') as fh:
-    flux_file = fh.read().replace('\n', '')
-    flux_list = flux_file.split()
-
-    flux_to_plot = np.zeros((num_groups, x_cells,
-        y_cells, z_cells))
-    for g in range(num_groups):
-        for i in range(x_cells):
-            for j in range(y_cells):
-                for k in range(z_cells):
-                    flux_to_plot[g][i][j][k] = \
-                            flux_list[g*x_cells*y_cells*z_cells \
-                            + i*y_cells*z_cells + j*z_cells + k]
+if __name__ == '__main__':
+    file_name = sys.argv[1] if len(sys.argv) > 1 else 'flux.bin'
+    header, planes, flux_to_plot, flux_deviation = read_flux(file_name)
 
     index = 1
-    for g in range(num_groups):
+    for g in range(len(flux_to_plot)):
         plot_heat_map(flux_to_plot[g], index, repeat = 5,
                 title = ('Group ' + str(g+1)))
-
@@ -0,0 +1,304 @@
+/*
+ @file      Geometry.cpp
+ @brief     contains functions for the Geometry class
+ @author    Luke Eure
+ @date      April 5 2016
+*/
+
+#include "Geometry.h"
+
+/*
+ @brief     constructor for an empty Geometry
+*/
+Geometry::Geometry() {}
+
+/*
+ @brief     deconstructor
+*/
+Geometry::~Geometry() {}
+
+/*
+ @brief     adds a cell to the geometry. The cell's surfaces must all have
+            been added to it first.
+ @param     cell the cell
+*/
+void Geometry::addCell(Cell* cell) {
+    int index = _cells.size();
+    _cells.push_back(cell);
+    _cell_surfaces.push_back(std::vector <int>());
+    for (int s=0; s<cell->getNumSurfaces(); ++s) {
+        Surface* surface = cell->getSurface(s);
+        int k = 0;
+        while (k < _surfaces.size() && _surfaces[k] != surface)
+            k++;
+        if (k == _surfaces.size()) {
+            _surfaces.push_back(surface);
+            _surface_cells.push_back(std::vector <int>());
+        }
+        _surface_cells[k].push_back(index);
+        _cell_surfaces[index].push_back(k);
+    }
+}
+
+/*
+ @brief     finds the cell holding a neutron by checking every cell
+ @param     position the location of the neutron
+ @param     direction the direction of travel of the neutron
+ @return    the index of the cell, or -1 if the neutron is in no cell
+*/
+int Geometry::findCell(double* position, double* direction) {
+    for (int c=0; c<_cells.size(); ++c) {
+        if (_cells[c]->contains(position, direction))
+            return c;
+    }
+    return -1;
+}
+
+/*
+ @brief     finds the cell a neutron enters after crossing a surface of its
+            cell, checking the other cells bounded by the surface first
+ @param     cell the index of the cell the neutron leaves
+ @param     surface_index the index of the surface crossed among the cell's
+            surfaces
+ @param     position the location of the neutron, on the surface
+ @param     direction the direction of travel of the neutron
+ @return    the index of the new cell, or -1 if the neutron is in no cell
+*/
+int Geometry::findNextCell(int cell, int surface_index, double* position,
+        double* direction) {
+    std::vector <int> &neighbors =
+        _surface_cells[_cell_surfaces[cell][surface_index]];
+    for (int n=0; n<neighbors.size(); ++n) {
+        if (neighbors[n] != cell
+                && _cells[neighbors[n]]->contains(position, direction))
+            return neighbors[n];
+    }
+    return findCell(position, direction);
+}
+
+/*
+ @brief     finds the cell holding a neutron at every level of universes,
+            starting from this geometry as the root
+ @param     position the location of the neutron
+ @param     direction the direction of travel of the neutron
+ @param     path filled with the cells holding the neutron
+ @return    false if the neutron is in no cell at some level
+*/
+bool Geometry::findCell(double* position, double* direction,
+        CellPath* path) {
+    for (int axis=0; axis<3; ++axis)
+        path->offsets[0][axis] = 0.0;
+    return findCell(position, direction, path, 0);
+}
+
+/*
+ @brief     finds the cell holding a neutron in this universe and every
+            universe inside it
+ @param     position the location of the neutron, in the root's coordinates
+ @param     direction the direction of travel of the neutron
+ @param     path the cells holding the neutron, with the offset of this
+            universe's level set. The cells from the level on are filled in.
+ @param     level the level of this universe
+ @return    false if the neutron is in no cell at some level
+*/
+bool Geometry::findCell(double* position, double* direction,
+        CellPath* path, int level) {
+    double local[3];
+    for (int axis=0; axis<3; ++axis)
+        local[axis] = position[axis] - path->offsets[level][axis];
+    return enterCell(findCell(local, direction), position, direction, path,
+            level);
+}
+
+/*
+ @brief     finds the distance along a neutron's direction of travel to the
+            nearest surface of its cell at any level, or the nearest edge of
+            a lattice element holding it
+ @details   the level, surface and axis of the crossing are saved in the
+            path for crossSurface(). Crossings within SURFACE_TOLERANCE of
+            each other are taken at the outermost level, and at a cell's
+            surface before the edge of the lattice filling it, so a lattice
+            edge on a cell surface leaves the lattice and an element edge on
+            a surface of its universe moves to the next element.
+ @param     path the cells holding the neutron
+ @param     position the location of the neutron
+ @param     direction the direction of travel of the neutron
+ @return    the distance to the nearest crossing, infinite if there is none
+*/
+double Geometry::getBoundaryDistance(CellPath* path, double* position,
+        double* direction) {
+    double nearest = INFINITY;
+    path->crossing_level = -1;
+    path->crossing_surface = -1;
+    path->crossing_axis = 0;
+    for (int level=0; level<path->num_levels; ++level) {
+        double local[3];
+        for (int axis=0; axis<3; ++axis)
+            local[axis] = position[axis] - path->offsets[level][axis];
+        Cell* cell = path->universes[level]->getCell(path->cells[level]);
+
+        // the surfaces of the cell at this level
+        int surface_index;
+        double distance = cell->getBoundaryDistance(local, direction,
+                &surface_index);
+        if (distance < nearest - SURFACE_TOLERANCE) {
+            nearest = distance;
+            path->crossing_level = level;
+            path->crossing_surface = surface_index;
+        }
+
+        // the edges of the element of the lattice filling the cell
+        if (level + 1 < path->num_levels) {
+            int axis;
+            distance = cell->getLattice()->getElementDistance(local,
+                    direction, path->elements[level], &axis);
+            if (distance < nearest - SURFACE_TOLERANCE) {
+                nearest = distance;
+                path->crossing_level = level;
+                path->crossing_surface = -1;
+                path->crossing_axis = axis;
+            }
+        }
+    }
+    return nearest;
+}
+
+/*
+ @brief     returns the surface found by getBoundaryDistance()
+ @param     path the cells holding the neutron
+ @return    a pointer to the surface, or NULL if the crossing is the edge
+            of a lattice element
+*/
+Surface* Geometry::getCrossingSurface(CellPath* path) {
+    int level = path->crossing_level;
+    if (level < 0 || path->crossing_surface < 0)
+        return NULL;
+    return path->universes[level]->getCell(path->cells[level])
+        ->getSurface(path->crossing_surface);
+}
+
+/*
+ @brief     finds the normal of the surface found by getBoundaryDistance()
+ @param     path the cells holding the neutron
+ @param     position the location of the neutron, on the surface
+ @param     normal an array of three values to fill with the unit normal
+*/
+void Geometry::getCrossingNormal(CellPath* path, double* position,
+        double* normal) {
+    int level = path->crossing_level;
+    double local[3];
+    for (int axis=0; axis<3; ++axis)
+        local[axis] = position[axis] - path->offsets[level][axis];
+    getCrossingSurface(path)->getNormal(local, normal);
+}
+
+/*
+ @brief     moves a neutron across the surface or lattice element edge found
+            by getBoundaryDistance() into the cells on the other side
+ @param     path the cells holding the neutron, updated to the new cells
+ @param     position the location of the neutron, on the crossing
+ @param     direction the direction of travel of the neutron
+ @return    false if the neutron is in no cell on the other side
+*/
+bool Geometry::crossSurface(CellPath* path, double* position,
+        double* direction) {
+    int level = path->crossing_level;
+    if (level < 0) {
+        path->num_levels = 0;
+        return false;
+    }
+    Geometry* universe = path->universes[level];
+
+    // step to the next element of the lattice, which must cover its cell
+    if (path->crossing_surface < 0) {
+        Lattice* lattice = universe->getCell(path->cells[level])
+            ->getLattice();
+        int* element = path->elements[level];
+        int axis = path->crossing_axis;
+        element[axis] += direction[axis] > 0.0 ? 1 : -1;
+        if (element[axis] < 0 || element[axis] >= lattice->getAxisSize(axis)) {
+            path->num_levels = 0;
+            return false;
+        }
+        double center[3];
+        lattice->getCenter(element, center);
+        for (int a=0; a<3; ++a)
+            path->offsets[level + 1][a] = path->offsets[level][a] + center[a];
+        return lattice->getUniverse(element)->findCell(position, direction,
+                path, level + 1);
+    }
+
+    // find the neighbouring cell in the same universe
+    double local[3];
+    for (int axis=0; axis<3; ++axis)
+        local[axis] = position[axis] - path->offsets[level][axis];
+    int next_cell = universe->findNextCell(path->cells[level],
+            path->crossing_surface, local, direction);
+    return universe->enterCell(next_cell, position, direction, path, level);
+}
+
+/*
+ @brief     returns a cell of the geometry
+ @param     index the index of the cell
+ @return    a pointer to the cell
+*/
+Cell* Geometry::getCell(int index) {
+    return _cells[index];
+}
+
+/*
+ @brief     returns the number of cells in the geometry
+ @return    the number of cells
+*/
+int Geometry::getNumCells() {
+    return _cells.size();
+}
+
+/*
+ @brief     puts a neutron in a cell of this universe at a level of its
+            path, then finds its cells in the universes filling the cell
+ @param     cell the index of the cell, or -1 if the neutron is in none
+ @param     position the location of the neutron, in the root's coordinates
+ @param     direction the direction of travel of the neutron
+ @param     path the cells holding the neutron, with the offset of this
+            universe's level set
+ @param     level the level of this universe
+ @return    false if the neutron is in no cell at some level, or the
+            universes are nested deeper than MAX_UNIVERSE_LEVELS
+*/
+bool Geometry::enterCell(int cell, double* position, double* direction,
+        CellPath* path, int level) {
+    path->universes[level] = this;
+    path->cells[level] = cell;
+    path->num_levels = level + 1;
+    path->material = NULL;
+    if (cell < 0 || (_cells[cell]->getLattice() != NULL
+                && level + 1 == MAX_UNIVERSE_LEVELS)) {
+        path->num_levels = 0;
+        return false;
+    }
+
+    // a material fills the cell
+    Lattice* lattice = _cells[cell]->getLattice();
+    if (lattice == NULL) {
+        path->material = _cells[cell]->getMaterial();
+        return true;
+    }
+
+    // descend into the universe of the lattice element holding the neutron
+    double local[3];
+    for (int axis=0; axis<3; ++axis)
+        local[axis] = position[axis] - path->offsets[level][axis];
+    int* element = path->elements[level];
+    if (!lattice->findElement(local, direction, element)) {
+        path->num_levels = 0;
+        return false;
+    }
+    double center[3];
+    lattice->getCenter(element, center);
+    for (int axis=0; axis<3; ++axis)
+        path->offsets[level + 1][axis] = path->offsets[level][axis]
+            + center[axis];
+    return lattice->getUniverse(element)->findCell(position, direction,
+            path, level + 1);
+}
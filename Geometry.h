@@ -0,0 +1,66 @@
+/*
+ @file      Geometry.h
+ @brief     contains the Geometry class
+ @author    Luke Eure
+ @date      April 5 2016
+*/
+
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <vector>
+
+#include "Cell.h"
+#include "Lattice.h"
+#include "Cell_path.h"
+
+/*
+ @brief     a geometry built from cells bounded by surfaces, an alternative
+            to the voxels of a Mesh for problems such as pins in a lattice
+ @details   the cells should fill the bounding box without overlapping. The
+            geometry remembers which cells each surface bounds, so a neutron
+            crossing a surface is found in its new cell by checking those
+            cells first. A geometry can also be a universe filling the
+            elements of a Lattice, and a neutron is then followed through
+            every level of universes with a CellPath.
+*/
+class Geometry {
+
+public:
+    Geometry();
+    virtual ~Geometry();
+
+    void addCell(Cell* cell);
+    int findCell(double* position, double* direction);
+    int findNextCell(int cell, int surface_index, double* position,
+            double* direction);
+    bool findCell(double* position, double* direction, CellPath* path);
+    bool findCell(double* position, double* direction, CellPath* path,
+            int level);
+    double getBoundaryDistance(CellPath* path, double* position,
+            double* direction);
+    Surface* getCrossingSurface(CellPath* path);
+    void getCrossingNormal(CellPath* path, double* position,
+            double* normal);
+    bool crossSurface(CellPath* path, double* position, double* direction);
+    Cell* getCell(int index);
+    int getNumCells();
+
+private:
+    bool enterCell(int cell, double* position, double* direction,
+            CellPath* path, int level);
+
+    /** the cells of the geometry */
+    std::vector <Cell*> _cells;
+
+    /** the distinct surfaces bounding cells */
+    std::vector <Surface*> _surfaces;
+
+    /** the cells bounded by each distinct surface */
+    std::vector <std::vector <int> > _surface_cells;
+
+    /** the index in _surfaces of each bounding surface of each cell */
+    std::vector <std::vector <int> > _cell_surfaces;
+};
+
+#endif
@@ -0,0 +1,229 @@
+/*
+ @file      Grid.cpp
+ @brief     contains functions for the Grid class
+ @author    Luke Eure
+ @date      April 2 2016
+*/
+
+#include "Grid.h"
+
+/*
+ @brief     constructor for an empty Grid
+*/
+Grid::Grid() {
+    for (int axis=0; axis<3; ++axis)
+        _axis_sizes[axis] = 0;
+}
+
+/*
+ @brief     constructor for Grid class
+ @param     planes the coordinates of the grid planes along each axis in
+            increasing order, including the planes on the edges of the grid
+*/
+Grid::Grid(std::vector <std::vector <double> > &planes) {
+
+    // save the planes, which must increase along each axis
+    _planes = planes;
+    _planes.resize(3);
+    for (int axis=0; axis<3; ++axis) {
+        std::vector <double> &axis_planes = _planes[axis];
+        bool increasing = true;
+        for (int i=1; i<axis_planes.size(); ++i)
+            increasing = increasing && axis_planes[i] > axis_planes[i-1];
+        if (!increasing) {
+            std::cout << "Grid planes along axis " << axis << " are not in "
+                << "increasing order; sorting them" << std::endl;
+            std::sort(axis_planes.begin(), axis_planes.end());
+            axis_planes.erase(std::unique(axis_planes.begin(),
+                        axis_planes.end()), axis_planes.end());
+        }
+        if (axis_planes.size() < 2) {
+            std::cout << "A grid needs at least two planes along axis "
+                << axis << std::endl;
+            axis_planes.resize(2, axis_planes.empty() ? 0.0
+                    : axis_planes[0] + 1.0);
+        }
+        _axis_sizes[axis] = axis_planes.size() - 1;
+    }
+    buildCellLookup();
+}
+
+/*
+ @brief     deconstructor
+*/
+Grid::~Grid() {}
+
+/*
+ @brief     finds the cell holding a position. A position on a plane is in
+            the cell the direction heads into.
+ @param     position the location to find the cell of
+ @param     direction the direction of travel
+ @param     cell an array of three ints to fill with the cell number along
+            each axis
+*/
+void Grid::getCell(double* position, double* direction, int* cell) {
+    for (int axis=0; axis<3; ++axis) {
+        int cell_num = findCell(axis, position[axis]);
+
+        // a neutron on the lower plane of a cell heading down the axis is
+        // in the cell below
+        if (cell_num > 0 && position[axis] == _planes[axis][cell_num]
+                && direction[axis] < 0) {
+            cell_num --;
+        }
+        cell[axis] = cell_num;
+    }
+}
+
+/*
+ @brief     finds the cell along an axis holding a coordinate
+ @param     axis the axis
+ @param     coordinate the coordinate along the axis
+ @return    the cell whose lower plane is the last one at or below the
+            coordinate, limited to the cells of the grid
+*/
+int Grid::findCell(int axis, double coordinate) {
+    double* planes = &_planes[axis][0];
+    int last_cell = _axis_sizes[axis] - 1;
+    int num_bins = _lookup_cells[axis].size() - 1;
+    double position = (coordinate - planes[0]) * _lookup_scale[axis];
+    int bin = position < 0.0 ? 0 : (position >= num_bins ? num_bins - 1
+            : (int) position);
+
+    // search the planes between the cells of the bin's edges
+    int lower = _lookup_cells[axis][bin];
+    int upper = _lookup_cells[axis][bin + 1];
+    int cell = std::upper_bound(planes + lower + 1, planes + upper + 1,
+            coordinate) - planes - 1;
+
+    // correct for roundoff in the bin
+    while (cell < last_cell && coordinate >= planes[cell + 1])
+        cell++;
+    while (cell > 0 && coordinate < planes[cell])
+        cell--;
+    return cell;
+}
+
+/*
+ @brief     checks whether a position is inside the grid or on its edge
+ @param     position the location to check
+ @return    true if the position is within the outer planes along every axis
+*/
+bool Grid::contains(double* position) {
+    for (int axis=0; axis<3; ++axis) {
+        if (position[axis] < getBoundaryMin(axis)
+                || position[axis] > getBoundaryMax(axis))
+            return false;
+    }
+    return true;
+}
+
+/*
+ @brief     finds the index of a cell in arrays over all cells
+ @param     cell the cell number along each axis
+ @return    the cell index
+*/
+long Grid::getCellIndex(int* cell) {
+    return ((long) cell[0] * _axis_sizes[1] + cell[1]) * _axis_sizes[2]
+        + cell[2];
+}
+
+/*
+ @brief     returns the number of cells in the grid
+ @return    the number of cells
+*/
+long Grid::getNumCells() {
+    return (long) _axis_sizes[0] * _axis_sizes[1] * _axis_sizes[2];
+}
+
+/*
+ @brief     returns the number of cells along an axis
+ @param     axis the axis along which to count cells
+ @return    the number of cells
+*/
+int Grid::getAxisSize(int axis) {
+    return _axis_sizes[axis];
+}
+
+/*
+ @brief     returns the number of cells along every axis
+ @return    a pointer to the three axis sizes
+*/
+int* Grid::getAxisSizes() {
+    return _axis_sizes;
+}
+
+/*
+ @brief     returns the coordinate of a grid plane along an axis
+ @param     axis the axis the plane is normal to
+ @param     index the number of the plane, from 0 on the lower edge of the
+            grid to getAxisSize() on the upper edge
+ @return    the coordinate of the plane
+*/
+double Grid::getPlane(int axis, int index) {
+    return _planes[axis][index];
+}
+
+/*
+ @brief     returns the coordinates of all grid planes along an axis
+ @param     axis the axis the planes are normal to
+ @return    a pointer to the getAxisSize() + 1 plane coordinates
+*/
+double* Grid::getPlanes(int axis) {
+    return &_planes[axis][0];
+}
+
+/*
+ @brief     returns the minimum coordinate of the grid along an axis
+ @param     axis the axis along which to get the minimum
+ @return    the coordinate of the lowest plane
+*/
+double Grid::getBoundaryMin(int axis) {
+    return _planes[axis][0];
+}
+
+/*
+ @brief     returns the maximum coordinate of the grid along an axis
+ @param     axis the axis along which to get the maximum
+ @return    the coordinate of the highest plane
+*/
+double Grid::getBoundaryMax(int axis) {
+    return _planes[axis][_axis_sizes[axis]];
+}
+
+/*
+ @brief     checks whether another grid has exactly the same planes
+ @param     grid the grid to compare with
+ @return    true if the planes of the grids are identical
+*/
+bool Grid::samePlanes(Grid &grid) {
+    return _planes == grid._planes;
+}
+
+/*
+ @brief     builds the tables that findCell() uses to find the cell holding
+            a coordinate
+ @details   each axis is split into CELL_LOOKUP_FACTOR times as many equal
+            bins as it has cells, and each bin stores the cell holding its
+            lower edge. A coordinate's bin then brackets its cell between the
+            cells of the bin's two edges, which for all but the most uneven
+            grids are the same cell or neighbours.
+*/
+void Grid::buildCellLookup() {
+    _lookup_cells.resize(3);
+    _lookup_scale.resize(3);
+    for (int axis=0; axis<3; ++axis) {
+        std::vector <double> &planes = _planes[axis];
+        int num_bins = CELL_LOOKUP_FACTOR * _axis_sizes[axis];
+        double width = planes.back() - planes[0];
+        _lookup_scale[axis] = num_bins / width;
+        _lookup_cells[axis].resize(num_bins + 1);
+        int cell = 0;
+        for (int b=0; b<=num_bins; ++b) {
+            double edge = planes[0] + b * width / num_bins;
+            while (cell < _axis_sizes[axis] - 1 && edge >= planes[cell + 1])
+                cell++;
+            _lookup_cells[axis][b] = cell;
+        }
+    }
+}
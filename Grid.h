@@ -0,0 +1,62 @@
+/*
+ @file      Grid.h
+ @brief     contains the Grid class
+ @author    Luke Eure
+ @date      April 2 2016
+*/
+
+#ifndef GRID_H
+#define GRID_H
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+/** number of bins per cell in the tables used to find the cell holding a
+    coordinate */
+const int CELL_LOOKUP_FACTOR = 2;
+
+/*
+ @brief     a rectilinear grid of cells, given by the coordinates of its
+            planes along each axis
+ @details   the planes along each axis may be spaced unevenly. Cells are
+            numbered along each axis from the lowest coordinate up, and a
+            cell's index in arrays over all cells has the z cell number
+            fastest varying.
+*/
+class Grid {
+
+public:
+    Grid();
+    Grid(std::vector <std::vector <double> > &planes);
+    virtual ~Grid();
+
+    void getCell(double* position, double* direction, int* cell);
+    int findCell(int axis, double coordinate);
+    bool contains(double* position);
+    long getCellIndex(int* cell);
+    long getNumCells();
+    int getAxisSize(int axis);
+    int* getAxisSizes();
+    double getPlane(int axis, int index);
+    double* getPlanes(int axis);
+    double getBoundaryMin(int axis);
+    double getBoundaryMax(int axis);
+    bool samePlanes(Grid &grid);
+
+private:
+    void buildCellLookup();
+
+    /** the coordinates of the grid planes along each axis */
+    std::vector <std::vector <double> > _planes;
+
+    /** the number of cells along each axis */
+    int _axis_sizes[3];
+
+    /** for equal bins along each axis, the cell holding the lower edge of
+        each bin, and the number of bins per unit length */
+    std::vector <std::vector <int> > _lookup_cells;
+    std::vector <double> _lookup_scale;
+};
+
+#endif
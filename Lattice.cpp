@@ -0,0 +1,117 @@
+/*
+ @file      Lattice.cpp
+ @brief     contains functions for the Lattice class
+ @author    Luke Eure
+ @date      April 9 2016
+*/
+
+#include "Lattice.h"
+
+/*
+ @brief     constructor for Lattice class
+ @param     planes the coordinates of the planes bounding the elements along
+            each axis in increasing order, including the planes on the edges
+            of the lattice
+ @param     default_universe the universe filling every element until
+            setUniverse() is called
+*/
+Lattice::Lattice(std::vector <std::vector <double> > &planes,
+        Geometry* default_universe) : _grid(planes) {
+    _universes.resize(_grid.getNumCells(), default_universe);
+}
+
+/*
+ @brief     deconstructor
+*/
+Lattice::~Lattice() {}
+
+/*
+ @brief     fills an element of the lattice with a universe
+ @param     element the element number along each axis
+ @param     universe the universe, centred on the element
+*/
+void Lattice::setUniverse(int* element, Geometry* universe) {
+    for (int axis=0; axis<3; ++axis) {
+        if (element[axis] < 0 || element[axis] >= _grid.getAxisSize(axis)) {
+            std::cout << "Lattice element is outside the lattice"
+                << std::endl;
+            return;
+        }
+    }
+    _universes[_grid.getCellIndex(element)] = universe;
+}
+
+/*
+ @brief     returns the universe filling an element
+ @param     element the element number along each axis
+ @return    a pointer to the universe
+*/
+Geometry* Lattice::getUniverse(int* element) {
+    return _universes[_grid.getCellIndex(element)];
+}
+
+/*
+ @brief     finds the element holding a position. A position on a plane
+            between elements is in the element the direction heads into.
+ @param     position the location, in the coordinates of the lattice
+ @param     direction the direction of travel
+ @param     element an array of three ints to fill with the element number
+            along each axis
+ @return    false if the position is outside the lattice
+*/
+bool Lattice::findElement(double* position, double* direction,
+        int* element) {
+    if (!_grid.contains(position))
+        return false;
+    _grid.getCell(position, direction, element);
+    return true;
+}
+
+/*
+ @brief     finds the centre of an element, where the origin of its universe
+            is placed
+ @param     element the element number along each axis
+ @param     center an array of three coordinates to fill with the centre, in
+            the coordinates of the lattice
+*/
+void Lattice::getCenter(int* element, double* center) {
+    for (int axis=0; axis<3; ++axis) {
+        center[axis] = 0.5 * (_grid.getPlane(axis, element[axis])
+                + _grid.getPlane(axis, element[axis] + 1));
+    }
+}
+
+/*
+ @brief     finds the distance along a direction to the edge of an element
+ @param     position the location, in the coordinates of the lattice
+ @param     direction the direction of travel
+ @param     element the element holding the position
+ @param     axis set to the axis normal to the nearest edge
+ @return    the distance to the nearest edge
+*/
+double Lattice::getElementDistance(double* position, double* direction,
+        int* element, int* axis) {
+    double nearest = INFINITY;
+    *axis = 0;
+    for (int a=0; a<3; ++a) {
+        if (direction[a] == 0.0)
+            continue;
+        int plane = direction[a] > 0.0 ? element[a] + 1 : element[a];
+        double distance = (_grid.getPlane(a, plane) - position[a])
+            / direction[a];
+        if (distance < nearest) {
+            nearest = distance;
+            *axis = a;
+        }
+    }
+    return nearest > 0.0 ? nearest : 0.0;
+}
+
+/*
+ @brief     returns the number of elements along an axis
+ @param     axis the axis along which to count elements
+ @return    the number of elements
+*/
+int Lattice::getAxisSize(int axis) {
+    return _grid.getAxisSize(axis);
+}
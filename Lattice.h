@@ -0,0 +1,52 @@
+/*
+ @file      Lattice.h
+ @brief     contains the Lattice class
+ @author    Luke Eure
+ @date      April 9 2016
+*/
+
+#ifndef LATTICE_H
+#define LATTICE_H
+
+#include <iostream>
+#include <vector>
+#include <math.h>
+
+#include "Grid.h"
+
+class Geometry;
+
+/*
+ @brief     a rectilinear array of elements, each filled with a universe
+ @details   a universe is a Geometry defined once, about its own origin, and
+            placed with that origin at the centre of every element it fills.
+            A lattice of pins or assemblies therefore stores one pointer per
+            element rather than the cells of every copy. A Cell filled with
+            a lattice sees it in the coordinates of the cell's own universe.
+*/
+class Lattice {
+
+public:
+    Lattice(std::vector <std::vector <double> > &planes,
+            Geometry* default_universe);
+    virtual ~Lattice();
+
+    void setUniverse(int* element, Geometry* universe);
+    Geometry* getUniverse(int* element);
+    bool findElement(double* position, double* direction, int* element);
+    void getCenter(int* element, double* center);
+    double getElementDistance(double* position, double* direction,
+            int* element, int* axis);
+    int getAxisSize(int axis);
+
+private:
+
+    /** the planes bounding the elements */
+    Grid _grid;
+
+    /** the universe filling each element, indexed like the cells of the
+        grid */
+    std::vector <Geometry*> _universes;
+};
+
+#endif
@@ -20,25 +20,56 @@ Material::Material(std::vector <double> &sigma_t,
         std::vector <std::vector <double> > &sigma_s, double nu, 
         std::vector <double> &sigma_f, std::vector <double> &chi) {
 
+    // save number of groups and allocate the records
+    _num_groups = sigma_t.size();
+    _owned_record.assign(getRecordSize(_num_groups), 0.0);
+    _owned_alias_record.assign(getAliasRecordSize(_num_groups), 0);
+    _record = &_owned_record[0];
+    _alias_record = &_owned_alias_record[0];
+    setPointers();
+
     // store variables
-    _sigma_t = sigma_t;
-    _sigma_s = sigma_s;
+    _record[0] = nu;
     _nu = nu;
-    _sigma_f = sigma_f;
-    _chi = chi;
-   
-    // save number of groups
-    _num_groups = sigma_t.size();
-    _sigma_a.resize(_num_groups);
+    for (int i=0; i < _num_groups; ++i) {
+        _sigma_t[i] = sigma_t[i];
+        _sigma_f[i] = sigma_f[i];
+        _chi[i] = chi[i];
+        for (int j=0; j < _num_groups; ++j)
+            _sigma_s[i*_num_groups + j] = sigma_s[i][j];
+    }
 
     // calculate and save the value for absorption cross sections
     for (int i=0; i < _num_groups; ++i) {
-        _s_sum = 0.0;
+        double s_sum = 0.0;
         for (int j=0; j < _num_groups; ++j) {
-            _s_sum += _sigma_s[i][j];
+            s_sum += _sigma_s[i*_num_groups + j];
         }
-       _sigma_a[i] = _sigma_t[i] - _s_sum;
+       _sigma_a[i] = _sigma_t[i] - s_sum;
     }
+
+    // build the alias tables for sampling outgoing groups
+    for (int i=0; i < _num_groups; ++i)
+        buildAliasTable(&_sigma_s[i*_num_groups],
+                &_scatter_probability[i*_num_groups],
+                &_scatter_alias[i*_num_groups]);
+    buildAliasTable(_chi, _chi_probability, _chi_alias);
+}
+
+/*
+ @brief     constructor for a Material viewing records filled elsewhere,
+            such as those of a MaterialLibrary, which must outlive it
+ @param     num_groups the number of energy groups
+ @param     record the values of the material, of getRecordSize() doubles
+ @param     alias_record the alias indices of the material, of
+            getAliasRecordSize() ints
+*/
+Material::Material(int num_groups, double* record, int* alias_record) {
+    _num_groups = num_groups;
+    _record = record;
+    _alias_record = alias_record;
+    setPointers();
+    _nu = _record[0];
 }
 
 /*
@@ -46,6 +77,48 @@ Material::Material(std::vector <double> &sigma_t,
 */
 Material::~Material() {}
 
+/*
+ @brief     returns the number of doubles in the record of a material
+ @param     num_groups the number of energy groups
+ @return    the size of the record
+*/
+long Material::getRecordSize(int num_groups) {
+    return 1 + 5 * (long) num_groups + 2 * (long) num_groups * num_groups;
+}
+
+/*
+ @brief     returns the number of ints in the alias record of a material
+ @param     num_groups the number of energy groups
+ @return    the size of the alias record
+*/
+long Material::getAliasRecordSize(int num_groups) {
+    return num_groups + (long) num_groups * num_groups;
+}
+
+/*
+ @brief     returns the record holding the values of the material
+ @return    a pointer to the first of getRecordSize() doubles
+*/
+double* Material::getRecord() {
+    return _record;
+}
+
+/*
+ @brief     returns the record holding the alias indices of the material
+ @return    a pointer to the first of getAliasRecordSize() ints
+*/
+int* Material::getAliasRecord() {
+    return _alias_record;
+}
+
+/*
+ @brief     returns the number of energy groups of the material
+ @return    the number of groups
+*/
+int Material::getNumGroups() {
+    return _num_groups;
+}
+
 /*
  @brief     returns sigma_t for the material, a standard vector
             containing the total cross section for each energy group
@@ -57,13 +130,13 @@ double Material::getSigmaT(int group) {
 }
 
 /*
- @brief     returns sigma_s for the material, a standard vector containing the
-            scattering cross section for each energy group
+ @brief     returns sigma_s for the material, the scattering cross section
+            from a group into each energy group
  @param     group the energy group of the neutron
- @return    sigma_s, the scatttering cross section
+ @return    a pointer to the row of sigma_s, the scatttering cross section
 */
-std::vector <double> Material::getSigmaS(int group)  {
-    return _sigma_s[group];
+double* Material::getSigmaS(int group)  {
+    return &_sigma_s[group * _num_groups];
 }
 
 /*
@@ -95,6 +168,15 @@ double Material::getChi(int group) {
     return _chi[group];
 }
 
+/*
+ @brief     returns chi for the material, the initial energy distribution
+            of neutrons over all energy groups
+ @return    a pointer to chi, the neutron emission spectrum
+*/
+double* Material::getChi() {
+    return _chi;
+}
+
 /*
  @brief     returns sigma_a for the material, a standard vector containing the
             absorption cross section for each energy group
@@ -151,3 +233,131 @@ int Material::sampleNumFission(Neutron *neutron) {
     int add = (int) (neutron->arand() < _nu -lower);
     return lower + add;
 }
+
+/*
+ @brief     samples the neutron energy group after a scattering event
+ @param     group the neutron energy group before scattering
+ @param     neutron the neutron whose random number stream is used
+ @return    the neutron group after scattering
+*/
+int Material::sampleScatteredGroup(int group, Neutron *neutron) {
+    return sampleAliasTable(&_scatter_probability[group * _num_groups],
+            &_scatter_alias[group * _num_groups], neutron->arand());
+}
+
+/*
+ @brief     samples the neutron energy group after a scattering event from a
+            given random number
+ @param     group the neutron energy group before scattering
+ @param     r a random number in [0, 1)
+ @return    the neutron group after scattering
+*/
+int Material::sampleScatteredGroup(int group, double r) {
+    return sampleAliasTable(&_scatter_probability[group * _num_groups],
+            &_scatter_alias[group * _num_groups], r);
+}
+
+/*
+ @brief     samples the energy group of a neutron born from fission
+ @param     neutron the neutron whose random number stream is used
+ @return    the group number of the emitted neutron
+*/
+int Material::sampleChiGroup(Neutron *neutron) {
+    return sampleAliasTable(_chi_probability, _chi_alias, neutron->arand());
+}
+
+/*
+ @brief     points the cross sections and tables into the records
+*/
+void Material::setPointers() {
+    int n = _num_groups;
+    _sigma_t = &_record[1];
+    _sigma_a = &_record[1 + n];
+    _sigma_f = &_record[1 + 2*n];
+    _chi = &_record[1 + 3*n];
+    _chi_probability = &_record[1 + 4*n];
+    _sigma_s = &_record[1 + 5*n];
+    _scatter_probability = &_record[1 + 5*n + n*n];
+    _chi_alias = &_alias_record[0];
+    _scatter_alias = &_alias_record[n];
+}
+
+/*
+ @brief     builds a Walker alias table for sampling a group in proportion
+            to a set of weights in constant time
+ @details   each group i is kept with probability probability[i] and
+            otherwise replaced by alias[i], so that every column of the table
+            carries the same share of the total weight. The table is built
+            with Vose's method. If the weights sum to zero the last group is
+            always sampled.
+ @param     weights the unnormalized weight of each group
+ @param     probability filled with the probability of keeping each group
+ @param     alias filled with the group each one is otherwise replaced by
+*/
+void Material::buildAliasTable(double* weights, double* probability,
+        int* alias) {
+    int n = _num_groups;
+    for (int i=0; i<n; ++i) {
+        probability[i] = 1.0;
+        alias[i] = i;
+    }
+
+    double total = 0.0;
+    for (int i=0; i<n; ++i)
+        total += weights[i];
+    if (total <= 0.0) {
+        for (int i=0; i<n; ++i) {
+            probability[i] = 0.0;
+            alias[i] = n - 1;
+        }
+        return;
+    }
+
+    // split the scaled weights into columns under and over the average
+    std::vector <double> scaled(n);
+    std::vector <int> small;
+    std::vector <int> large;
+    for (int i=0; i<n; ++i) {
+        scaled[i] = weights[i] * n / total;
+        if (scaled[i] < 1.0)
+            small.push_back(i);
+        else
+            large.push_back(i);
+    }
+
+    // fill each small column with weight from a large one
+    while (!small.empty() && !large.empty()) {
+        int s = small.back();
+        int l = large.back();
+        small.pop_back();
+        probability[s] = scaled[s];
+        alias[s] = l;
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // whatever is left is full up to roundoff
+    for (int i=0; i<small.size(); ++i)
+        probability[small[i]] = 1.0;
+    for (int i=0; i<large.size(); ++i)
+        probability[large[i]] = 1.0;
+}
+
+/*
+ @brief     samples a group from an alias table with one random number
+ @param     probability the probability of keeping each group
+ @param     alias the group each one is otherwise replaced by
+ @param     r a random number in [0, 1)
+ @return    the sampled group
+*/
+int Material::sampleAliasTable(double* probability, int* alias, double r) {
+    int n = _num_groups;
+    double column = r * n;
+    int i = (int) column;
+    if (i >= n)
+        i = n - 1;
+    return column - i < probability[i] ? i : alias[i];
+}
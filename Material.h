@@ -16,6 +16,18 @@
 
 #include "Neutron.h"
 
+/*
+ @brief     the cross sections of a material and tables for sampling them
+ @details   all values of a material live in one contiguous record of
+            doubles, laid out as nu, then sigma_t, sigma_a, sigma_f, chi and
+            the alias probabilities of chi for each group, then the
+            scattering matrix and the alias probabilities of each of its rows
+            with the outgoing group fastest varying. The alias indices are in
+            a second record of ints, those of chi followed by those of each
+            scattering row. A material either owns its records or views
+            records held by a MaterialLibrary, so a whole library shares one
+            allocation.
+*/
 class Material {
 
 public:
@@ -23,44 +35,74 @@ public:
     Material(std::vector <double> &sigma_t, 
             std::vector <std::vector <double> > &sigma_s, double nu, 
             std::vector <double> &sigma_f, std::vector <double> &chi);
+    Material(int num_groups, double* record, int* alias_record);
     virtual ~Material();
     
+    static long getRecordSize(int num_groups);
+    static long getAliasRecordSize(int num_groups);
+    double* getRecord();
+    int* getAliasRecord();
+    int getNumGroups();
     double getSigmaT(int group);
     double getSigmaF(int group);
     double getChi(int group);
     double getSigmaA(int group);
-    std::vector <double> getSigmaS(int group);
+    double* getSigmaS(int group);
+    double* getChi();
     double getNu();
     int sampleInteraction(int group, Neutron *neutron);
     double sampleDistance(int group, Neutron *neutron);
     int sampleFission(int group, Neutron *neutron);
     int sampleNumFission(Neutron *neutron);
+    int sampleScatteredGroup(int group, Neutron *neutron);
+    int sampleScatteredGroup(int group, double r);
+    int sampleChiGroup(Neutron *neutron);
 
 private:
 
+    Material(const Material &material);
+    Material& operator=(const Material &material);
+    void setPointers();
+    void buildAliasTable(double* weights, double* probability, int* alias);
+    int sampleAliasTable(double* probability, int* alias, double r);
+
+    /** the record of values and the record of alias indices */
+    double* _record;
+    int* _alias_record;
+
+    /** storage for the records, if the material owns them */
+    std::vector <double> _owned_record;
+    std::vector <int> _owned_alias_record;
+
     /** total cross sections */
-    std::vector <double> _sigma_t;
+    double* _sigma_t;
 
     /** fission cross sections */
-    std::vector <double> _sigma_f;
+    double* _sigma_f;
 
     /** initial energy distribution */
-    std::vector <double> _chi;
+    double* _chi;
 
     /** absorption cross sections */
-    std::vector <double> _sigma_a;
+    double* _sigma_a;
 
-    /** scattering cross sections */
-    std::vector <std::vector <double> > _sigma_s;
+    /** scattering cross sections, one row for each incoming group */
+    double* _sigma_s;
 
     /** average number of neutrons released per fission event */
     double _nu;
 
-    /** summation of sigma_s */
-    double _s_sum;
-
     /** number of energy groups */
     int _num_groups;
+
+    /** alias tables of the scattering matrix rows: the probability of
+        keeping each column and the column it is otherwise replaced by */
+    double* _scatter_probability;
+    int* _scatter_alias;
+
+    /** alias table of the emission spectrum */
+    double* _chi_probability;
+    int* _chi_alias;
 };
 
 #endif
@@ -0,0 +1,433 @@
+/*
+ @file      Material_library.cpp
+ @brief     contains functions for the MaterialLibrary class
+ @details   a binary library is written in native byte order: a 64 byte
+            header holding the 8 byte magic "MGMCXSLB" then as 32 bit
+            integers the format version, the header size, the number of
+            groups, the number of materials and the size of a name, then
+            the name of each material in 32 bytes padded with zeros, then
+            the records of all materials as doubles, then their alias
+            records as 32 bit integers.
+ @author    Luke Eure
+ @date      March 28 2016
+*/
+
+#include "Material_library.h"
+
+/*
+ @brief     the values read for a material of a text library
+*/
+struct TextMaterial {
+    std::string name;
+    std::vector <double> sigma_t;
+    std::vector <double> sigma_s;
+    std::vector <double> sigma_f;
+    std::vector <double> nu_sigma_f;
+    std::vector <double> chi;
+    std::vector <double> nu;
+};
+
+/*
+ @brief     reads a number of values following a keyword
+ @param     tokens the words of the file
+ @param     position the position of the first value, moved past the values
+ @param     count the number of values to read
+ @param     values filled with the values
+ @return    true if the values were numbers
+*/
+static bool readValues(std::vector <std::string> &tokens, long* position,
+        long count, std::vector <double> &values) {
+    values.resize(count);
+    for (long i=0; i<count; ++i) {
+        if (*position >= tokens.size())
+            return false;
+        const char* word = tokens[*position].c_str();
+        char* end;
+        values[i] = strtod(word, &end);
+        if (end == word || *end != '\0')
+            return false;
+        (*position)++;
+    }
+    return true;
+}
+
+/*
+ @brief     checks the values read for a material and appends its records
+ @param     material the values read
+ @param     num_groups the number of energy groups
+ @param     records the records to append the values to
+ @param     alias_records the alias records to append the indices to
+ @return    true if the material was complete
+*/
+static bool addTextMaterial(TextMaterial &material, int num_groups,
+        std::vector <double> &records, std::vector <int> &alias_records) {
+    if (material.sigma_t.empty() || material.sigma_s.empty()) {
+        std::cout << "Material " << material.name << " needs sigma_t and "
+            << "sigma_s" << std::endl;
+        return false;
+    }
+
+    // work out nu and sigma_f from the two of sigma_f, nu and nu_sigma_f
+    // that are given
+    double nu = 0.0;
+    std::vector <double> sigma_f = material.sigma_f;
+    bool has_sigma_f = !sigma_f.empty();
+    bool has_nu = !material.nu.empty();
+    bool has_nu_sigma_f = !material.nu_sigma_f.empty();
+    if (has_nu)
+        nu = material.nu[0];
+    if (has_sigma_f && has_nu_sigma_f && !has_nu) {
+        double fission_sum = 0.0;
+        double nu_fission_sum = 0.0;
+        for (int g=0; g<num_groups; ++g) {
+            fission_sum += sigma_f[g];
+            nu_fission_sum += material.nu_sigma_f[g];
+        }
+        nu = fission_sum > 0.0 ? nu_fission_sum / fission_sum : 0.0;
+        for (int g=0; g<num_groups; ++g) {
+            if (fabs(material.nu_sigma_f[g] - nu * sigma_f[g])
+                    > 1e-6 * material.nu_sigma_f[g]) {
+                std::cout << "Material " << material.name << " has a nu "
+                    << "that changes with group; using its average " << nu
+                    << std::endl;
+                break;
+            }
+        }
+    }
+    else if (has_nu && has_nu_sigma_f && !has_sigma_f) {
+        sigma_f.resize(num_groups);
+        for (int g=0; g<num_groups; ++g)
+            sigma_f[g] = nu > 0.0 ? material.nu_sigma_f[g] / nu : 0.0;
+    }
+    else if (has_sigma_f != has_nu || has_nu_sigma_f) {
+        std::cout << "Material " << material.name << " needs exactly two of "
+            << "sigma_f, nu and nu_sigma_f" << std::endl;
+        return false;
+    }
+    if (sigma_f.empty())
+        sigma_f.assign(num_groups, 0.0);
+    if (material.chi.empty())
+        material.chi.assign(num_groups, 0.0);
+
+    std::vector <std::vector <double> > sigma_s(num_groups);
+    for (int g=0; g<num_groups; ++g)
+        sigma_s[g].assign(material.sigma_s.begin() + g*num_groups,
+                material.sigma_s.begin() + (g+1)*num_groups);
+    Material built(material.sigma_t, sigma_s, nu, sigma_f, material.chi);
+    records.insert(records.end(), built.getRecord(),
+            built.getRecord() + Material::getRecordSize(num_groups));
+    alias_records.insert(alias_records.end(), built.getAliasRecord(),
+            built.getAliasRecord() + Material::getAliasRecordSize(num_groups));
+    return true;
+}
+
+/*
+ @brief     constructor for an empty MaterialLibrary
+*/
+MaterialLibrary::MaterialLibrary() {
+    _num_groups = 0;
+    _records = NULL;
+    _alias_records = NULL;
+    _mapping = NULL;
+    _mapping_size = 0;
+}
+
+/*
+ @brief     deconstructor, which deletes the materials of the library
+*/
+MaterialLibrary::~MaterialLibrary() {
+    unload();
+}
+
+/*
+ @brief     loads a cross section library, replacing any loaded before.
+            Materials taken from an earlier library are deleted.
+ @param     file_name the name of a binary or text library
+ @return    true if the library was loaded
+*/
+bool MaterialLibrary::load(std::string file_name) {
+    unload();
+    FILE* file = fopen(file_name.c_str(), "rb");
+    if (file == NULL) {
+        std::cout << "Could not open cross section library " << file_name
+            << std::endl;
+        return false;
+    }
+    char magic[sizeof(LIBRARY_MAGIC)];
+    bool binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic)
+        && memcmp(magic, LIBRARY_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+
+    bool loaded = binary ? loadBinary(file_name) : loadText(file_name);
+    if (!loaded) {
+        unload();
+        return false;
+    }
+    createMaterials();
+    return true;
+}
+
+/*
+ @brief     writes the loaded library in the binary form, which later runs
+            load without parsing
+ @param     file_name the name of the file to write
+ @return    true if the file was written
+*/
+bool MaterialLibrary::writeBinary(std::string file_name) {
+    FILE* file = fopen(file_name.c_str(), "wb");
+    if (file == NULL) {
+        std::cout << "Could not open " << file_name << " for writing"
+            << std::endl;
+        return false;
+    }
+    char header[LIBRARY_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    int32_t fields[] = {LIBRARY_VERSION, LIBRARY_HEADER_SIZE, _num_groups,
+        (int32_t) _names.size(), LIBRARY_NAME_SIZE};
+    memcpy(header, LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC));
+    memcpy(header + sizeof(LIBRARY_MAGIC), fields, sizeof(fields));
+    fwrite(header, 1, sizeof(header), file);
+    for (int m=0; m<_names.size(); ++m) {
+        char name[LIBRARY_NAME_SIZE];
+        memset(name, 0, sizeof(name));
+        strncpy(name, _names[m].c_str(), LIBRARY_NAME_SIZE - 1);
+        fwrite(name, 1, sizeof(name), file);
+    }
+    fwrite(_records, sizeof(double),
+            _names.size() * Material::getRecordSize(_num_groups), file);
+    fwrite(_alias_records, sizeof(int32_t),
+            _names.size() * Material::getAliasRecordSize(_num_groups), file);
+    bool written = ferror(file) == 0;
+    fclose(file);
+    if (!written)
+        std::cout << "Could not write " << file_name << std::endl;
+    return written;
+}
+
+/*
+ @brief     returns the number of energy groups of the library
+ @return    the number of groups
+*/
+int MaterialLibrary::getNumGroups() {
+    return _num_groups;
+}
+
+/*
+ @brief     returns the number of materials in the library
+ @return    the number of materials
+*/
+int MaterialLibrary::getNumMaterials() {
+    return _materials.size();
+}
+
+/*
+ @brief     returns the name of a material
+ @param     index the position of the material in the library
+ @return    the name of the material
+*/
+std::string MaterialLibrary::getName(int index) {
+    return _names[index];
+}
+
+/*
+ @brief     returns a material of the library, which is deleted with the
+            library
+ @param     index the position of the material in the library
+ @return    a pointer to the material
+*/
+Material* MaterialLibrary::getMaterial(int index) {
+    return _materials[index];
+}
+
+/*
+ @brief     finds a material of the library by name
+ @param     name the name of the material
+ @return    a pointer to the material, or NULL if there is none by that name
+*/
+Material* MaterialLibrary::getMaterial(std::string name) {
+    for (int m=0; m<_names.size(); ++m) {
+        if (_names[m] == name)
+            return _materials[m];
+    }
+    std::cout << "No material named " << name << " in the library"
+        << std::endl;
+    return NULL;
+}
+
+/*
+ @brief     parses a text library into records held in memory
+ @param     file_name the name of the file
+ @return    true if the file was parsed
+*/
+bool MaterialLibrary::loadText(std::string file_name) {
+    std::ifstream file(file_name.c_str());
+    std::vector <std::string> tokens;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::string word;
+        while (words >> word)
+            tokens.push_back(word);
+    }
+
+    std::vector <TextMaterial> materials;
+    long position = 0;
+    while (position < tokens.size()) {
+        std::string keyword = tokens[position++];
+        std::vector <double> values;
+        bool read;
+        long g = _num_groups;
+        if (keyword == "groups") {
+            read = _num_groups == 0 && readValues(tokens, &position, 1,
+                    values) && values[0] >= 1;
+            if (read)
+                _num_groups = (int) values[0];
+        }
+        else if (keyword == "material") {
+            read = _num_groups > 0 && position < tokens.size();
+            if (read) {
+                materials.push_back(TextMaterial());
+                materials.back().name = tokens[position++];
+            }
+        }
+        else if (materials.empty()) {
+            read = false;
+        }
+        else if (keyword == "sigma_t") {
+            read = readValues(tokens, &position, g, materials.back().sigma_t);
+        }
+        else if (keyword == "sigma_s") {
+            read = readValues(tokens, &position, g*g,
+                    materials.back().sigma_s);
+        }
+        else if (keyword == "sigma_f") {
+            read = readValues(tokens, &position, g, materials.back().sigma_f);
+        }
+        else if (keyword == "nu_sigma_f") {
+            read = readValues(tokens, &position, g,
+                    materials.back().nu_sigma_f);
+        }
+        else if (keyword == "nu") {
+            read = readValues(tokens, &position, 1, materials.back().nu);
+        }
+        else if (keyword == "chi") {
+            read = readValues(tokens, &position, g, materials.back().chi);
+        }
+        else {
+            read = false;
+        }
+        if (!read) {
+            std::cout << "Could not read " << keyword << " in cross section "
+                << "library " << file_name << std::endl;
+            return false;
+        }
+    }
+    if (materials.empty()) {
+        std::cout << "Cross section library " << file_name << " has no "
+            << "materials" << std::endl;
+        return false;
+    }
+
+    // build the records of every material into one table
+    _owned_records.reserve(materials.size()
+            * Material::getRecordSize(_num_groups));
+    _owned_alias_records.reserve(materials.size()
+            * Material::getAliasRecordSize(_num_groups));
+    for (int m=0; m<materials.size(); ++m) {
+        if (!addTextMaterial(materials[m], _num_groups, _owned_records,
+                    _owned_alias_records))
+            return false;
+        _names.push_back(materials[m].name);
+    }
+    _records = &_owned_records[0];
+    _alias_records = &_owned_alias_records[0];
+    return true;
+}
+
+/*
+ @brief     maps a binary library, whose records are then used in place
+ @param     file_name the name of the file
+ @return    true if the file was mapped
+*/
+bool MaterialLibrary::loadBinary(std::string file_name) {
+    FILE* file = fopen(file_name.c_str(), "rb");
+    if (file == NULL) {
+        std::cout << "Could not open cross section library " << file_name
+            << std::endl;
+        return false;
+    }
+    char header[LIBRARY_HEADER_SIZE];
+    bool read = fread(header, 1, sizeof(header), file) == sizeof(header);
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    int32_t fields[5];
+    memcpy(fields, header + sizeof(LIBRARY_MAGIC), sizeof(fields));
+    long num_materials = fields[3];
+    long records_offset = fields[1] + num_materials * fields[4];
+    long expected_size = records_offset + num_materials
+        * (Material::getRecordSize(fields[2]) * sizeof(double)
+        + Material::getAliasRecordSize(fields[2]) * sizeof(int32_t));
+    if (!read || fields[0] != LIBRARY_VERSION
+            || fields[1] != LIBRARY_HEADER_SIZE || fields[2] < 1
+            || num_materials < 1 || fields[4] != LIBRARY_NAME_SIZE
+            || file_size != expected_size) {
+        std::cout << "Cross section library " << file_name << " is damaged "
+            << "or of another version" << std::endl;
+        fclose(file);
+        return false;
+    }
+
+    _mapping = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fileno(file),
+            0);
+    fclose(file);
+    if (_mapping == MAP_FAILED) {
+        _mapping = NULL;
+        std::cout << "Could not map cross section library " << file_name
+            << std::endl;
+        return false;
+    }
+    _mapping_size = file_size;
+
+    char* bytes = (char*) _mapping;
+    _num_groups = fields[2];
+    for (long m=0; m<num_materials; ++m) {
+        const char* name = bytes + fields[1] + m * LIBRARY_NAME_SIZE;
+        _names.push_back(std::string(name, strnlen(name,
+                        LIBRARY_NAME_SIZE)));
+    }
+    _records = (double*) (bytes + records_offset);
+    _alias_records = (int*) (_records
+            + num_materials * Material::getRecordSize(_num_groups));
+    return true;
+}
+
+/*
+ @brief     creates a Material viewing each record
+*/
+void MaterialLibrary::createMaterials() {
+    long record_size = Material::getRecordSize(_num_groups);
+    long alias_record_size = Material::getAliasRecordSize(_num_groups);
+    for (long m=0; m<_names.size(); ++m)
+        _materials.push_back(new Material(_num_groups,
+                    _records + m * record_size,
+                    _alias_records + m * alias_record_size));
+}
+
+/*
+ @brief     deletes the materials and releases the records
+*/
+void MaterialLibrary::unload() {
+    for (int m=0; m<_materials.size(); ++m)
+        delete _materials[m];
+    _materials.clear();
+    _names.clear();
+    _owned_records.clear();
+    _owned_alias_records.clear();
+    if (_mapping != NULL)
+        munmap(_mapping, _mapping_size);
+    _mapping = NULL;
+    _mapping_size = 0;
+    _records = NULL;
+    _alias_records = NULL;
+    _num_groups = 0;
+}
@@ -0,0 +1,100 @@
+/*
+ @file      Material_library.h
+ @brief     contains the MaterialLibrary class
+ @author    Luke Eure
+ @date      March 28 2016
+*/
+
+#ifndef MATERIAL_LIBRARY_H
+#define MATERIAL_LIBRARY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+
+#include "Material.h"
+
+/** identifies a binary cross section library */
+const char LIBRARY_MAGIC[8] = {'M', 'G', 'M', 'C', 'X', 'S', 'L', 'B'};
+
+/** version of the binary library format */
+const int32_t LIBRARY_VERSION = 1;
+
+/** size in bytes of the header of a binary library */
+const int LIBRARY_HEADER_SIZE = 64;
+
+/** size in bytes of each material name in a binary library */
+const int LIBRARY_NAME_SIZE = 32;
+
+/*
+ @brief     a set of materials loaded from a multigroup cross section file
+ @details   the records of all materials are stored back to back in one
+            table, which the Material objects of the library view. A text
+            library is parsed into a table in memory; a binary library,
+            written by writeBinary(), is mapped straight from the file so
+            loading it costs no parsing or copying. The text format is a
+            series of whitespace separated keywords, each followed by its
+            values, with anything after a '#' ignored:
+                groups G
+                material NAME
+                sigma_t  G values
+                sigma_s  G*G values, one row for each incoming group
+                sigma_f  G values
+                nu       one value, or nu_sigma_f with G values
+                chi      G values
+            The number of groups comes first, then each material starts
+            with its name. Two of sigma_f, nu and nu_sigma_f give the
+            fission data; a material with none of them does not fission.
+*/
+class MaterialLibrary {
+
+public:
+    MaterialLibrary();
+    virtual ~MaterialLibrary();
+
+    bool load(std::string file_name);
+    bool writeBinary(std::string file_name);
+    int getNumGroups();
+    int getNumMaterials();
+    std::string getName(int index);
+    Material* getMaterial(int index);
+    Material* getMaterial(std::string name);
+
+private:
+    MaterialLibrary(const MaterialLibrary &library);
+    MaterialLibrary& operator=(const MaterialLibrary &library);
+    bool loadText(std::string file_name);
+    bool loadBinary(std::string file_name);
+    void createMaterials();
+    void unload();
+
+    /** number of energy groups of every material */
+    int _num_groups;
+
+    /** names of the materials */
+    std::vector <std::string> _names;
+
+    /** the records of all materials, one after another */
+    double* _records;
+    int* _alias_records;
+
+    /** storage for the records of a text library */
+    std::vector <double> _owned_records;
+    std::vector <int> _owned_alias_records;
+
+    /** the mapped file of a binary library, or NULL */
+    void* _mapping;
+    size_t _mapping_size;
+
+    /** materials viewing the records */
+    std::vector <Material*> _materials;
+};
+
+#endif
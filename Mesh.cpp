@@ -8,65 +8,42 @@
 #include "Mesh.h"
 
 /*
- @brief     constructor for Mesh class
+ @brief     constructor for a Mesh of uniform cells
+ @param     bounds the boundaries of the geometry
+ @param     delta_x the width of the cells along the x axis
+ @param     delta_y the width of the cells along the y axis
+ @param     delta_z the width of the cells along the z axis
+ @param     default_material the material filling every cell
+ @param     num_groups the number of energy groups
 */
 Mesh::Mesh(Boundaries bounds, double delta_x, double delta_y, double delta_z,
         Material* default_material, int num_groups) {
     
-    // save deltas 
-    _delta_axes.push_back(delta_x);
-    _delta_axes.push_back(delta_y);
-    _delta_axes.push_back(delta_z);
-
-    // save number of groups
-    _num_groups = num_groups;
-
-    // save boundary mins
-    for (int axis=0; axis<3; ++axis) {
-        _boundary_mins.push_back(bounds.getSurfaceCoord(axis, 0));
-    }
-
-    // save axis sizes
+    // place the grid planes one cell width apart
+    double deltas[3] = {delta_x, delta_y, delta_z};
+    std::vector <std::vector <double> > planes(3);
     for (int axis=0; axis<3; ++axis) {
-        int size = (bounds.getSurfaceCoord(axis, MAX) - _boundary_mins[axis])
-            / _delta_axes[axis];
-        _axis_sizes.push_back(size);
-    }
-    
-    // resize _flux and set all its elements = 0
-    _flux.resize(_num_groups);
-    for (int g=0; g<_num_groups; ++g) {
-        _flux[g].resize(_axis_sizes[0]);
-        for (int i=0; i<_axis_sizes[0]; ++i) {
-            _flux[g][i].resize(_axis_sizes[1]);
-            for (int j=0; j<_axis_sizes[1]; ++j) {
-                _flux[g][i][j].resize(_axis_sizes[2]);
-                for (int k=0; k<_axis_sizes[2]; ++k) {
-                    _flux[g][i][j][k] = 0.0;
-                }
-            }
-        }
-    }
-
-    // create materials array
-    _cell_materials.resize(_axis_sizes[0]);
-    for (int i=0; i<_axis_sizes[0]; ++i) {
-        _cell_materials[i].resize(_axis_sizes[1]);
-        for (int j=0; j<_axis_sizes[1]; ++j) {
-            _cell_materials[i][j].resize(_axis_sizes[2]);
-            for (int k=0; k<_axis_sizes[2]; ++k) {
-                _cell_materials[i][j][k] = default_material;
-            }
-        }
+        double boundary_min = bounds.getSurfaceCoord(axis, MIN);
+        int size = (bounds.getSurfaceCoord(axis, MAX) - boundary_min)
+            / deltas[axis];
+        for (int i=0; i<=size; ++i)
+            planes[axis].push_back(boundary_min + i * deltas[axis]);
     }
+    initialize(planes, default_material, num_groups);
+}
 
-    // resize vectors
-    _maxes.resize(3);
-    _mins.resize(3);
-    _min_locations.resize(3);
-    _max_locations.resize(3);
-    _default_direction.resize(3);
-    _cell_num_vector.resize(3);
+/*
+ @brief     constructor for a rectilinear Mesh, whose cells may have a
+            different width in each row along each axis
+ @param     planes the coordinates of the grid planes along each axis in
+            increasing order, including the planes on the edges of the
+            geometry
+ @param     default_material the material filling every cell
+ @param     num_groups the number of energy groups
+*/
+Mesh::Mesh(std::vector <std::vector <double> > &planes,
+        Material* default_material, int num_groups) {
+    initialize(planes, default_material, num_groups);
 }
 
 /*
@@ -77,103 +54,539 @@ Mesh::~Mesh() {}
 /*
  @brief     get the cell containing a neutron at a given location with a given
             direction of travel
- @param     position a vector containing the location to find the cell of
+ @param     position an array containing the location to find the cell of
  @param     direction the direction the nuetron is travelling
- @return    a vector denoting the cell of the location and direction
+ @param     cell_num_vector an array of three ints to fill with the cell of
+            the location and direction
 */
-std::vector <int> Mesh::getCell(std::vector <double>& position,
-        std::vector <double>& direction) {
-    for (int i=0; i<3; ++i) {
-        _cell_num = (int)((position[i] - _boundary_mins[i])/_delta_axes[i]);
-        
-        // correct error if neutron is on upper boundary of cell
-        // the rounding is neaded because decimal accuracy gets off
-        _move_cell = position[i] == _boundary_mins[i] + _cell_num
-            * _delta_axes[i] & direction[i] < 0;
-        if (_cell_num == _axis_sizes[i] | _move_cell) {
-            _cell_num --;
-        }
-        if (_cell_num == -1) {
-            _cell_num = 0;
+void Mesh::getCell(double* position, double* direction,
+        int* cell_num_vector) {
+
+    _grid.getCell(position, direction, cell_num_vector);
+}
+
+/*
+ @brief     finds the distance along a neutron's direction of travel to the
+            next surface of its cell along each axis
+ @details   together with crossSurface() this walks the neutron through the
+            mesh one cell at a time without searching for its cell after
+            each crossing
+ @param     neutron a neutron with its position, direction and cell set
+ @param     crossings an array to fill with the distance to the next
+            surface along each axis, infinite if the neutron travels
+            parallel to the axis' surfaces
+*/
+void Mesh::getCrossingDistances(Neutron* neutron, double* crossings) {
+    int* cell = neutron->getCell();
+    for (int axis=0; axis<3; ++axis) {
+        double direction = neutron->getDirection(axis);
+        if (direction == 0.0) {
+            crossings[axis] = INFINITY;
+            continue;
         }
-        _cell_num_vector[i] =_cell_num;
+
+        // the surface ahead is the cell max if moving up the axis
+        double surface = _grid.getPlane(axis, cell[axis] + (direction > 0.0));
+        crossings[axis] = (surface - neutron->getPosition(axis)) / direction;
+        if (crossings[axis] < 0.0)
+            crossings[axis] = 0.0;
+    }
+}
+
+/*
+ @brief     moves a neutron that has reached a surface of its cell into the
+            neighbouring cell along an axis
+ @details   the neutron is placed exactly on the surface and the distance to
+            the next surface along the axis is set to the width of the cell
+            it enters. If the surface is on the edge of the mesh the cell is
+            left unchanged and the distance is set to the width of the cell,
+            ready for a reflection.
+ @param     neutron a neutron sitting on a surface of its cell
+ @param     axis the axis normal to the surface
+ @param     crossings the distance to the next surface along each axis
+ @return    true if the neutron moved to a new cell, false if the surface
+            is on the edge of the mesh
+*/
+bool Mesh::crossSurface(Neutron* neutron, int axis, double* crossings) {
+    double direction = neutron->getDirection(axis);
+    min_max side = direction > 0.0 ? MAX : MIN;
+    int cell_num = neutron->getCell()[axis];
+
+    // place neutron on the surface to eliminate roundoff error
+    double* planes = _grid.getPlanes(axis);
+    neutron->setPosition(axis, planes[cell_num + side]);
+
+    // check for the edge of the mesh
+    if ((side == MIN && cell_num == 0)
+            || (side == MAX && cell_num == _grid.getAxisSize(axis) - 1)) {
+        crossings[axis] = (planes[cell_num + 1] - planes[cell_num])
+            / fabs(direction);
+        return false;
     }
-    return _cell_num_vector;
+    neutron->changeCell(axis, side);
+    cell_num += side == MAX ? 1 : -1;
+    crossings[axis] = (planes[cell_num + 1] - planes[cell_num])
+        / fabs(direction);
+    return true;
 }
 
 /*
- @brief     add the distance a neutron has traveled within the cell to the flux
-            array
- @param     cell a vector containing a cell
+ @brief     add the distance a neutron has traveled within a flux cell to the
+            flux of the current batch
+ @param     cell a vector containing a cell of the flux grid
  @param     distance a distance to be added to the cell flux
  @param     group a group to which this distance should be added
 */
-void Mesh::fluxAdd(std::vector <int> &cell, double distance, int group) {
-    _flux[group][cell[0]][cell[1]][cell[2]] += distance;
+void Mesh::fluxAdd(int* cell, double distance, int group) {
+    _batch_flux.add(cell, group, distance);
 }
 
 /*
- @brief     set the value of each element in the flux array to 0
+ @brief     add a track a neutron travels within a mesh cell to a
+            thread-private flux array shaped like the mesh flux
+ @details   if the flux is on the mesh cells the track is added to the
+            neutron's cell, otherwise it is split over the flux grid
+ @param     cell the mesh cell of the track
+ @param     position the start of the track
+ @param     direction the direction of travel
+ @param     distance the length of the track
+ @param     weight the weight of the neutron, which scales the track
+ @param     group the energy group of the neutron
+ @param     flux the flux array to be added to
 */
-void Mesh::fluxClear() {
-    for (int g=0; g<_num_groups; ++g) {
-        for (int i=0; i<_axis_sizes[0]; ++i) {
-            for (int j=0; j<_axis_sizes[1]; ++j) {
-                for (int k=0; k<_axis_sizes[2]; ++k) {
-                    _flux[g][i][j][k] = 0.0;
-                }
-            }
+void Mesh::fluxAddTrack(int* cell, double* position, double* direction,
+        double distance, double weight, int group, FluxArray &flux) {
+    if (_flux_on_mesh)
+        flux.add(cell, group, distance * weight);
+    else
+        fluxAddTrack(position, direction, distance, weight, group, flux);
+}
+
+/*
+ @brief     add a track to a thread-private flux array shaped like the mesh
+            flux, splitting it at every plane of the flux grid it crosses
+            and adding each piece to the flux cell it lies in. Any part
+            outside the flux grid is not tallied.
+ @param     position the start of the track
+ @param     direction the direction of travel
+ @param     distance the length of the track
+ @param     weight the weight of the neutron, which scales the track
+ @param     group the energy group of the neutron
+ @param     flux the flux array to be added to
+*/
+void Mesh::fluxAddTrack(double* position, double* direction,
+        double distance, double weight, int group, FluxArray &flux) {
+
+    // clip the track to the flux grid
+    double start = 0.0;
+    double end = distance;
+    for (int axis=0; axis<3; ++axis) {
+        double low = _flux_grid.getBoundaryMin(axis) - position[axis];
+        double high = _flux_grid.getBoundaryMax(axis) - position[axis];
+        if (direction[axis] == 0.0) {
+            if (low > 0.0 || high < 0.0)
+                return;
+            continue;
+        }
+        double enter = low / direction[axis];
+        double leave = high / direction[axis];
+        if (enter > leave)
+            std::swap(enter, leave);
+        start = std::max(start, enter);
+        end = std::min(end, leave);
+    }
+    if (start >= end)
+        return;
+
+    // find the flux cell where the track enters and the distance from the
+    // start of the track to the next plane along each axis
+    double entry[3];
+    for (int axis=0; axis<3; ++axis)
+        entry[axis] = position[axis] + start * direction[axis];
+    int flux_cell[3];
+    double next_plane[3];
+    _flux_grid.getCell(entry, direction, flux_cell);
+    for (int axis=0; axis<3; ++axis)
+        next_plane[axis] = getNextPlane(axis, flux_cell[axis], position,
+                direction);
+
+    // walk the flux cells along the track
+    double traveled = start;
+    while (traveled < end) {
+        int axis = 0;
+        for (int a=1; a<3; ++a) {
+            if (next_plane[a] < next_plane[axis])
+                axis = a;
         }
+        double reached = std::min(next_plane[axis], end);
+        flux.add(flux_cell, group, (reached - traveled) * weight);
+        traveled = reached;
+
+        // step through every plane reached at once, for edges and corners
+        for (int a=0; a<3 && traveled < end; ++a) {
+            if (next_plane[a] - traveled > CROSSING_TOLERANCE)
+                continue;
+            flux_cell[a] += direction[a] > 0.0 ? 1 : -1;
+            if (flux_cell[a] < 0 || flux_cell[a] >= _flux_grid.getAxisSize(a))
+                return;
+            next_plane[a] = getNextPlane(a, flux_cell[a], position,
+                    direction);
+        }
+    }
+}
+
+/*
+ @brief     add a collision estimate of the flux at a point to a
+            thread-private flux array shaped like the mesh flux
+ @param     cell the mesh cell of the point
+ @param     position the location of the point
+ @param     direction the direction of travel of the neutron
+ @param     value the estimate to add
+ @param     group the energy group of the neutron
+ @param     flux the flux array to be added to
+*/
+void Mesh::fluxAddCollision(int* cell, double* position, double* direction,
+        double value, int group, FluxArray &flux) {
+    if (_flux_on_mesh) {
+        flux.add(cell, group, value);
+        return;
     }
+    if (!_flux_grid.contains(position))
+        return;
+    int flux_cell[3];
+    _flux_grid.getCell(position, direction, flux_cell);
+    flux.add(flux_cell, group, value);
 }
 
 /*
- @brief     return the flux array
- @return    returns the 4d flux vector
+ @brief     add a thread-private flux array into the flux of the current
+            batch
+ @param     flux a flux array of the same shape and layout as the mesh flux
 */
-std::vector <std::vector <std::vector <std::vector <double> > > > 
-        Mesh::getFlux() {
+void Mesh::fluxReduce(FluxView flux) {
+    _batch_flux.add(flux);
+}
+
+/*
+ @brief     set the value of each element in the flux arrays to 0 and forget
+            the batches ended
+*/
+void Mesh::fluxClear() {
+    _flux.clear();
+    _batch_flux.clear();
+    _flux_squared.clear();
+    _num_flux_batches = 0;
+}
+
+/*
+ @brief     adds the flux of the current batch and its square to the sums
+            over batches, and clears it for the next batch
+*/
+void Mesh::fluxEndBatch() {
+    double* sum = _flux.getValues();
+    double* batch = _batch_flux.getValues();
+    double* squared = _flux_squared.getValues();
+    long size = _flux.getSize();
+    #pragma omp simd
+    for (long i=0; i<size; ++i) {
+        sum[i] += batch[i];
+        squared[i] += batch[i] * batch[i];
+        batch[i] = 0.0;
+    }
+    _num_flux_batches++;
+}
+
+/*
+ @brief     sets the order the flux is stored in, clearing it
+ @param     layout GROUP_OUTER to store each group's cells together, or
+            GROUP_INNER to store each cell's groups together, which keeps
+            the groups of a cell in one cache line
+*/
+void Mesh::setFluxLayout(FluxLayout layout) {
+    _flux = FluxArray(_flux_grid.getAxisSizes(), _num_groups, layout);
+    _batch_flux = _flux;
+    _flux_squared = _flux;
+    _num_flux_batches = 0;
+}
+
+/*
+ @brief     tallies the flux on a grid of its own instead of the mesh cells,
+            clearing it
+ @details   the flux grid may be coarser or finer than the mesh or cover
+            only part of it. Tracks are split where they cross its planes,
+            so the flux resolution can be set apart from the geometry.
+ @param     planes the coordinates of the flux grid planes along each axis,
+            in increasing order
+*/
+void Mesh::setFluxGrid(std::vector <std::vector <double> > &planes) {
+    _flux_grid = Grid(planes);
+    _flux_on_mesh = _flux_grid.samePlanes(_grid);
+    setFluxLayout(_flux.getLayout());
+}
+
+/*
+ @brief     returns the grid the flux is tallied on, which is the mesh grid
+            unless setFluxGrid() was called
+ @return    a reference to the flux grid
+*/
+Grid& Mesh::getFluxGrid() {
+    return _flux_grid;
+}
+
+/*
+ @brief     tells whether the flux is tallied on the cells of the mesh
+ @return    true if the flux grid has the planes of the mesh
+*/
+bool Mesh::getFluxOnMesh() {
+    return _flux_on_mesh;
+}
+
+/*
+ @brief     return a view of the flux array, copying no flux
+ @return    a view of the flux of each cell and group summed over the
+            batches ended, valid until the flux layout is changed or the
+            mesh is destroyed
+*/
+FluxView Mesh::getFlux() {
     return _flux;
 }
 
+/*
+ @brief     return a view of the flux of the current batch
+ @return    a view of the flux of each cell and group in the current batch
+*/
+FluxView Mesh::getBatchFlux() {
+    return _batch_flux;
+}
+
+/*
+ @brief     return a view of the sum of the squares of the batch fluxes
+ @return    a view of the sum of squares of each cell and group
+*/
+FluxView Mesh::getFluxSquared() {
+    return _flux_squared;
+}
+
+/*
+ @brief     returns the number of batches summed in the flux
+ @return    the number of batches ended
+*/
+int Mesh::getNumFluxBatches() {
+    return _num_flux_batches;
+}
+
+/*
+ @brief     sets the number of batches summed in the flux, used when the
+            flux is restored from a checkpoint
+ @param     num_batches the number of batches
+*/
+void Mesh::setNumFluxBatches(int num_batches) {
+    _num_flux_batches = num_batches;
+}
+
 /*
  @brief     returns the coordinate for the maximum in the cell
- @param     cell_cell number vector containing the number of a cell to find the 
+ @param     cell_number array containing the number of a cell to find the 
             max of
- @return    a vector containing the maximum location of that cell in
+ @param     maxes an array to fill with the maximum location of that cell in
             each dimension
 */
-std::vector <double> Mesh::getCellMax(std::vector <int> &cell_number) {
+void Mesh::getCellMax(int* cell_number, double* maxes) {
     for (int i=0; i<3; ++i) {
-        _maxes[i] = (cell_number[i] + 1) * _delta_axes[i] + _boundary_mins[i];
+        maxes[i] = _grid.getPlane(i, cell_number[i] + 1);
     }
-    return _maxes;
 }
 
 /*
  @brief     returns the coordinate for the minimum in the cell
- @param     cell_cell number vector containing the number of a cell to find the 
+ @param     cell_number array containing the number of a cell to find the 
             min of
- @return    a vector containing the minimum location of that cell in
+ @param     mins an array to fill with the minimum location of that cell in
             each dimension
 */
-std::vector <double> Mesh::getCellMin(std::vector <int> &cell_number) {
+void Mesh::getCellMin(int* cell_number, double* mins) {
     for (int i=0; i<3; ++i) {
-        _mins[i] = cell_number[i] * _delta_axes[i] + _boundary_mins[i];
+        mins[i] = _grid.getPlane(i, cell_number[i]);
     }
-    return _mins;
 }
 
 /*
  @brief     returns the material of a given cell
- @param     cell_number vector containing the number of a cell to find the 
+ @param     cell_number array containing the number of a cell to find the 
             material of
  @return    the material of the cell
 */
-Material* Mesh::getMaterial(std::vector <int> &cell_number) {
-    Material* mat;
-    mat = _cell_materials[cell_number[0]][cell_number[1]][cell_number[2]];
-    return mat;
+Material* Mesh::getMaterial(int* cell_number) {
+    return getMaterial(getCellIndex(cell_number));
+}
+
+/*
+ @brief     returns the material of a cell given by its cell index
+ @param     cell_index the index of the cell, as found by getCellIndex()
+ @return    the material of the cell
+*/
+Material* Mesh::getMaterial(long cell_index) {
+    if (_wide_cell_material_ids.empty())
+        return _materials[_cell_material_ids[cell_index]];
+    return _materials[_wide_cell_material_ids[cell_index]];
+}
+
+/*
+ @brief     finds the index of a cell in arrays over all cells, with the z
+            cell number fastest varying
+ @param     cell_number array containing the number of the cell along each
+            axis
+ @return    the cell index
+*/
+long Mesh::getCellIndex(int* cell_number) {
+    return _grid.getCellIndex(cell_number);
+}
+
+/*
+ @brief     returns the number of distinct materials placed in the mesh,
+            including any that have since been covered by others
+ @return    the number of materials
+*/
+int Mesh::getNumMaterials() {
+    return _materials.size();
+}
+
+/*
+ @brief     finds the id of a material, adding it to the mesh's materials
+            if it is new. Ids are widened to two bytes when a 257th material
+            is added.
+ @param     material the material
+ @return    the id of the material, or -1 if the mesh is full
+*/
+int Mesh::getMaterialId(Material* material) {
+    for (int m=0; m<_materials.size(); ++m) {
+        if (_materials[m] == material)
+            return m;
+    }
+    if (_materials.size() == MAX_MESH_MATERIALS) {
+        std::cout << "A mesh can hold at most " << MAX_MESH_MATERIALS
+            << " materials" << std::endl;
+        return -1;
+    }
+    if (_materials.size() == 256) {
+        _wide_cell_material_ids.assign(_cell_material_ids.begin(),
+                _cell_material_ids.end());
+        std::vector <uint8_t>().swap(_cell_material_ids);
+    }
+    _materials.push_back(material);
+    return _materials.size() - 1;
+}
+
+/*
+ @brief     sets the material id of a cell
+ @param     cell_index the index of the cell
+ @param     material_id the id of the material
+*/
+void Mesh::setMaterialId(long cell_index, int material_id) {
+    if (_wide_cell_material_ids.empty())
+        _cell_material_ids[cell_index] = material_id;
+    else
+        _wide_cell_material_ids[cell_index] = material_id;
+}
+
+/*
+ @brief     returns the coordinate of a grid plane along an axis
+ @param     axis the axis the plane is normal to
+ @param     index the number of the plane, from 0 on the lower edge of the
+            mesh to getAxisSize() on the upper edge
+ @return    the coordinate of the plane
+*/
+double Mesh::getPlane(int axis, int index) {
+    return _grid.getPlane(axis, index);
+}
+
+/*
+ @brief     returns the coordinates of all grid planes along an axis
+ @param     axis the axis the planes are normal to
+ @return    a pointer to the getAxisSize() + 1 plane coordinates
+*/
+double* Mesh::getPlanes(int axis) {
+    return _grid.getPlanes(axis);
+}
+
+/*
+ @brief     returns the minimum coordinate of the mesh along an axis
+ @param     axis the axis along which to get the minimum
+ @return    the minimum coordinate of the mesh
+*/
+double Mesh::getBoundaryMin(int axis) {
+    return _grid.getBoundaryMin(axis);
+}
+
+/*
+ @brief     returns the maximum coordinate of the mesh along an axis
+ @param     axis the axis along which to get the maximum
+ @return    the maximum coordinate of the mesh
+*/
+double Mesh::getBoundaryMax(int axis) {
+    return _grid.getBoundaryMax(axis);
+}
+
+/*
+ @brief     returns the number of cells along an axis
+ @param     axis the axis along which to count cells
+ @return    the number of cells
+*/
+int Mesh::getAxisSize(int axis) {
+    return _grid.getAxisSize(axis);
+}
+
+/*
+ @brief     finds the largest and smallest total cross section in each group
+            over the materials filling the mesh
+ @details   must be called again if the materials are changed with
+            fillMaterials()
+*/
+void Mesh::computeMajorants() {
+    _majorants.assign(_num_groups, 0.0);
+    _minorants.assign(_num_groups, INFINITY);
+
+    // find which materials still fill a cell
+    std::vector <bool> used(_materials.size(), false);
+    long num_cells = _grid.getNumCells();
+    for (long c=0; c<num_cells; ++c) {
+        if (_wide_cell_material_ids.empty())
+            used[_cell_material_ids[c]] = true;
+        else
+            used[_wide_cell_material_ids[c]] = true;
+    }
+
+    for (int m=0; m<_materials.size(); ++m) {
+        if (!used[m])
+            continue;
+        for (int g=0; g<_num_groups; ++g) {
+            double sigma_t = _materials[m]->getSigmaT(g);
+            if (sigma_t > _majorants[g])
+                _majorants[g] = sigma_t;
+            if (sigma_t < _minorants[g])
+                _minorants[g] = sigma_t;
+        }
+    }
+}
+
+/*
+ @brief     returns the largest total cross section in the mesh
+ @param     group the energy group
+ @return    the majorant cross section, as found by computeMajorants()
+*/
+double Mesh::getMajorant(int group) {
+    return _majorants[group];
+}
+
+/*
+ @brief     returns the ratio of the smallest to the largest total cross
+            section in the mesh, the lowest possible probability that a
+            delta tracking collision is real
+ @param     group the energy group
+ @return    the majorant ratio, as found by computeMajorants()
+*/
+double Mesh::getMajorantRatio(int group) {
+    return _minorants[group] / _majorants[group];
 }
 
 /*
@@ -185,25 +598,31 @@ Material* Mesh::getMaterial(std::vector <int> &cell_number) {
 void Mesh::fillMaterials(Material* material_type,
         std::vector <std::vector <double> > &material_bounds) {
     
-    // copy the value of material_bounds to locations and nudge the upper
-    // limit down so it is contained within the highest cell
+    // a lower limit on a plane starts the cell above it and an upper limit
+    // on a plane ends the cell below it
+    double min_locations[3];
+    double max_locations[3];
+    double up[3] = {1.0, 1.0, 1.0};
+    double down[3] = {-1.0, -1.0, -1.0};
     for (int i=0; i<3; ++i) {
-        _min_locations[i] = material_bounds[i][0];
-        _max_locations[i] = material_bounds[i][1] - _delta_axes[i] / 10;
-    
-        // put the smallest and largest cell values along each
-        // axis in a list
-        _default_direction[i] = 0.0;
+        min_locations[i] = material_bounds[i][0];
+        max_locations[i] = material_bounds[i][1];
     }
-
-    _smallest_cell = getCell(_min_locations, _default_direction);
-    _largest_cell = getCell(_max_locations, _default_direction);
+    int smallest_cell[3];
+    int largest_cell[3];
+    getCell(min_locations, up, smallest_cell);
+    getCell(max_locations, down, largest_cell);
+    int material_id = getMaterialId(material_type);
+    if (material_id < 0)
+        return;
     
     // fill the cells with material_type
-    for (int i=_smallest_cell[0]; i<=_largest_cell[0]; ++i) {
-        for (int j=_smallest_cell[1]; j<=_largest_cell[1]; ++j) {
-            for (int k=_smallest_cell[2]; k<=_largest_cell[2]; ++k) {
-                _cell_materials[i][j][k] = material_type;
+    int cell[3];
+    for (cell[0]=smallest_cell[0]; cell[0]<=largest_cell[0]; ++cell[0]) {
+        for (cell[1]=smallest_cell[1]; cell[1]<=largest_cell[1]; ++cell[1]) {
+            for (cell[2]=smallest_cell[2]; cell[2]<=largest_cell[2];
+                    ++cell[2]) {
+                setMaterialId(getCellIndex(cell), material_id);
             }
         }
     }
@@ -214,16 +633,57 @@ void Mesh::fillMaterials(Material* material_type,
             the geometry
  @param     position a cartesian coordinate denoting a position in the geometry
 */
-bool Mesh::positionInBounds(std::vector <double> &position) {
+bool Mesh::positionInBounds(double* position) {
     for (int axis=0; axis<3; ++axis) {
-        double _boundary_max = _boundary_mins[axis]
-            + _delta_axes[axis] * _axis_sizes[axis];
-
         // check the boundaries
-        if (position[axis] < _boundary_mins[axis]
-                | position[axis] > _boundary_max) {
+        if (position[axis] < getBoundaryMin(axis)
+                | position[axis] > getBoundaryMax(axis)) {
             return false;
         }
     }
     return true;
 }
+
+/*
+ @brief     sets up the grid, materials and flux of a new mesh
+ @param     planes the coordinates of the grid planes along each axis
+ @param     default_material the material filling every cell
+ @param     num_groups the number of energy groups
+*/
+void Mesh::initialize(std::vector <std::vector <double> > &planes,
+        Material* default_material, int num_groups) {
+
+    // save number of groups
+    _num_groups = num_groups;
+
+    // the flux is on the mesh cells until another grid is set
+    _grid = Grid(planes);
+    _flux_grid = _grid;
+    _flux_on_mesh = true;
+    
+    // allocate the flux with all its elements = 0
+    setFluxLayout(GROUP_OUTER);
+
+    // fill every cell with the default material, id 0
+    _materials.push_back(default_material);
+    _cell_material_ids.assign(_grid.getNumCells(), 0);
+}
+
+/*
+ @brief     finds the distance along a track to the next plane of the flux
+            grid along an axis
+ @param     axis the axis
+ @param     flux_cell the flux cell number along the axis
+ @param     position the start of the track
+ @param     direction the direction of travel
+ @return    the distance from the start of the track, infinite if the track
+            is parallel to the planes
+*/
+double Mesh::getNextPlane(int axis, int flux_cell, double* position,
+        double* direction) {
+    if (direction[axis] == 0.0)
+        return INFINITY;
+    double plane = _flux_grid.getPlane(axis, flux_cell
+            + (direction[axis] > 0.0));
+    return (plane - position[axis]) / direction[axis];
+}
@@ -10,80 +10,127 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <math.h>
+#include <stdint.h>
 
 #include "Material.h"
 #include "Boundaries.h"
 #include "Surface.h"
+#include "Neutron.h"
+#include "Flux_array.h"
+#include "Grid.h"
 
+/** surfaces closer than this to a neutron are crossed together with the
+    nearest one */
+const double CROSSING_TOLERANCE = 1e-12;
+
+/** largest number of materials a mesh can hold */
+const int MAX_MESH_MATERIALS = 65536;
+
+/*
+ @brief     a rectilinear grid of cells, each filled with one material, which
+            also holds the flux
+ @details   the grid planes along each axis may be spaced unevenly, so thin
+            regions can be resolved without refining the whole geometry. The
+            flux is tallied on the mesh cells or on a separate flux grid.
+*/
 class Mesh {
 public:
     Mesh(Boundaries bounds, double delta_x, double delta_y, double delta_z,
             Material* default_material, int num_groups);
+    Mesh(std::vector <std::vector <double> > &planes,
+            Material* default_material, int num_groups);
     virtual ~Mesh();
 
-    void fluxAdd(std::vector <int> &cell, double distance, int group);
+    void fluxAdd(int* cell, double distance, int group);
+    void fluxAddTrack(int* cell, double* position, double* direction,
+            double distance, double weight, int group, FluxArray &flux);
+    void fluxAddTrack(double* position, double* direction, double distance,
+            double weight, int group, FluxArray &flux);
+    void fluxAddCollision(int* cell, double* position, double* direction,
+            double value, int group, FluxArray &flux);
+    void fluxReduce(FluxView flux);
     void fluxClear();
+    void fluxEndBatch();
+    void setFluxLayout(FluxLayout layout);
+    void setFluxGrid(std::vector <std::vector <double> > &planes);
+    Grid& getFluxGrid();
+    bool getFluxOnMesh();
+    void computeMajorants();
     void fillMaterials(Material* material_type,
             std::vector <std::vector <double> > &material_bounds);
-    bool positionInBounds(std::vector <double> &position);
-    std::vector <int> getCell(std::vector <double>& position,
-            std::vector <double>& direction);
-    std::vector <double> getCellMax(std::vector <int> &cell_number);
-    std::vector <double> getCellMin(std::vector <int> &cell_number);
-    std::vector <std::vector <std::vector <std::vector <double> > > > getFlux();
-    Material* getMaterial(std::vector <int> &cell_number);
+    bool crossSurface(Neutron* neutron, int axis, double* crossings);
+    bool positionInBounds(double* position);
+    void getCrossingDistances(Neutron* neutron, double* crossings);
+    void getCell(double* position, double* direction, int* cell_num_vector);
+    void getCellMax(int* cell_number, double* maxes);
+    void getCellMin(int* cell_number, double* mins);
+    FluxView getFlux();
+    FluxView getBatchFlux();
+    FluxView getFluxSquared();
+    int getNumFluxBatches();
+    void setNumFluxBatches(int num_batches);
+    Material* getMaterial(int* cell_number);
+    Material* getMaterial(long cell_index);
+    long getCellIndex(int* cell_number);
+    int getNumMaterials();
+    double getPlane(int axis, int index);
+    double* getPlanes(int axis);
+    double getMajorant(int group);
+    double getMajorantRatio(int group);
+    double getBoundaryMin(int axis);
+    double getBoundaryMax(int axis);
+    int getAxisSize(int axis);
     
 private:
 
-    /** the width of the cell along each axis */
-    std::vector <double> _delta_axes;
-
-    /** the minimum locations on the geometry in each direction */
-    std::vector <double> _boundary_mins;
-
-    /** cell max along each axis */
-    std::vector <double> _maxes;
-
-    /** cell min along each axis */
-    std::vector <double> _mins;
+    void initialize(std::vector <std::vector <double> > &planes,
+            Material* default_material, int num_groups);
+    double getNextPlane(int axis, int flux_cell, double* position,
+            double* direction);
+    int getMaterialId(Material* material);
+    void setMaterialId(long cell_index, int material_id);
 
-    /** minimum location to be filled by a material type along each axis */ 
-    std::vector <double> _min_locations;
+    /** the grid of cells filled with materials */
+    Grid _grid;
 
-    /** maximum location to be filled by a material type along each axis */ 
-    std::vector <double> _max_locations;
+    /** the grid the flux is tallied on, and whether it is the same as the
+        mesh grid */
+    Grid _flux_grid;
+    bool _flux_on_mesh;
 
-    /** 0, 0, 0 direction vector */
-    std::vector <double> _default_direction;
+    /** the neutron flux through each cell in each group, summed over the
+        batches ended */
+    FluxArray _flux;
 
-    /** the number of cells along each axis */
-    std::vector <int> _axis_sizes;
+    /** the flux of the current batch */
+    FluxArray _batch_flux;
 
-    /** the cell number along each axis */
-    std::vector <int> _cell_num_vector;
+    /** the sum of the squares of the batch fluxes */
+    FluxArray _flux_squared;
 
-    /** largest cell to be filled with material */
-    std::vector <int> _smallest_cell;
+    /** the number of batches summed in the flux */
+    int _num_flux_batches;
+    
+    /** the distinct materials in the mesh, indexed by material id */
+    std::vector <Material*> _materials;
 
-    /** smallest cell to be filled with material */
-    std::vector <int> _largest_cell;
+    /** the material id of each cell, by cell index. Ids are stored in one
+        byte while the mesh holds at most 256 materials and in two bytes
+        after that; only one of the arrays is in use */
+    std::vector <uint8_t> _cell_material_ids;
+    std::vector <uint16_t> _wide_cell_material_ids;
 
-    /** the neutron flux through each cell */
-    std::vector <std::vector <std::vector <std::vector <double> > > > _flux;
-    
-    /** materials of each cell */
-    std::vector <std::vector <std::vector <Material*> > > _cell_materials;
+    /** largest total cross section in the mesh in each group */
+    std::vector <double> _majorants;
 
-    /** a cell number */
-    int _cell_num;
+    /** smallest total cross section in the mesh in each group */
+    std::vector <double> _minorants;
 
     /** the number of energy groups */
     int _num_groups;
 
-    /** bool for use in corrections when a neutron is on a cell boundary */
-    bool _move_cell;
-
 };
 
 #endif
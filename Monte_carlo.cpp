@@ -7,59 +7,544 @@
 
 #include "Monte_carlo.h"
 
+/*
+ @brief     generates and transports neutron histories with the default
+            run settings
+ @param     n_histories number of neutron histories to run
+ @param     bounds a Boundaries object containing the limits of the
+            bounding box
+ @param     mesh a Mesh object containing information about the mesh
+ @param     num_batches the number of batches to be tested
+ @param     num_groups the number of neutron energy groups
+*/
+void generateNeutronHistories(int n_histories, Boundaries bounds,
+        Mesh &mesh, int num_batches, int num_groups) {
+    Settings settings;
+    generateNeutronHistories(n_histories, bounds, mesh, num_batches,
+            num_groups, settings);
+}
+
 /*
  @brief     generates and transports neutron histories, calculates the mean
             crow distance
  @param     n_histories number of neutron histories to run
- @param     mat a Material object containing information
-            about the material
  @param     bounds a Boundaries object containing the limits of the
             bounding box
  @param     mesh a Mesh object containing information about the mesh
  @param     num_batches the number of batches to be tested
  @param     num_groups the number of neutron energy groups
+ @param     settings a Settings object containing the run options
 */
 void generateNeutronHistories(int n_histories, Boundaries bounds,
-        Mesh &mesh, int num_batches, int num_groups) {
+        Mesh &mesh, int num_batches, int num_groups, Settings &settings) {
+
+    // find the share of each batch run by this process
+    initializeParallel();
+    bool master = getRank() == 0;
+    int first_history;
+    int last_history;
+    getRankHistories(n_histories, &first_history, &last_history);
 
-    // create arrays for tallies and fissions
-    std::vector <Tally> tallies(5);
-    Fission fission_banks;
+    // tally the events of every history, then those requested in settings
+    Tally event_tally;
+    for (int t=0; t<NUM_TALLY_NAMES; ++t)
+        event_tally.addScore(EVENT_SCORE);
+    std::vector <Tally*> tallies;
+    tallies.push_back(&event_tally);
+    tallies.insert(tallies.end(), settings.getTallies().begin(),
+            settings.getTallies().end());
+    for (int t=0; t<tallies.size(); ++t)
+        tallies[t]->clear();
+    int num_saved_tallies = tallies.size();
+
+    // coarse mesh values are scored during mesh surface tracking only, in
+    // a tally after those in settings
+    Cmfd* cmfd = settings.getCmfd();
+    if (cmfd != NULL && (settings.getGeometry() != NULL
+                || settings.getDeltaTracking()
+                || !settings.getPopulationControl())) {
+        if (master) {
+            std::cout << "CMFD needs surface tracking through the mesh and "
+                << "population control, running without it" << std::endl;
+        }
+        cmfd = NULL;
+    }
+    if (cmfd != NULL) {
+        tallies.push_back(cmfd->getTally());
+        tallies.back()->clear();
+    }
+
+    // the batch estimates of k, kept to average over active batches
+    Tally k_tally;
+    for (int e=0; e<NUM_K_ESTIMATORS; ++e)
+        k_tally.addScore(EVENT_SCORE);
+    std::vector <std::vector <double> > k_samples;
+    std::vector <double> k(NUM_K_ESTIMATORS);
+    double combined_k = 0.0;
+    double combined_k_error = 0.0;
+
+    // create the fission banks, leaving room for k well above 1
+    long site_capacity = (long) FISSION_BANK_CAPACITY
+        * (last_history - first_history);
+    Fission fission_banks(site_capacity);
     
     bool first_round = true;
 
-    for (int batch=1; batch <= num_batches; ++batch) {
+    // fission site buffers of each thread, kept between batches so they
+    // only grow in the first few
+    int max_threads = 1;
+#ifdef _OPENMP
+    max_threads = omp_get_max_threads();
+#endif
+    std::vector <std::vector <double> > thread_site_buffers(max_threads);
+    std::vector <std::vector <int> > thread_history_buffers(max_threads);
+
+    // sites of every thread gathered and sorted by history, reserved once
+    // and reused every batch
+    std::vector <double> batch_sites;
+    std::vector <int> batch_site_histories;
+    std::vector <std::pair <int, int> > site_order;
+    std::vector <double> sorted_sites;
+    batch_sites.reserve(site_capacity * SITE_SIZE);
+    batch_site_histories.reserve(site_capacity);
+    site_order.reserve(site_capacity);
+    sorted_sites.reserve(site_capacity * SITE_SIZE);
+
+    // neutrons split off the history each thread is following, with room
+    // reserved so splitting never allocates
+    std::vector <std::vector <Neutron> > thread_split_buffers(max_threads);
+    for (int thread=0; thread<max_threads; ++thread)
+        thread_split_buffers[thread].reserve(MAX_SPLIT_NEUTRONS);
+
+    // tallies of each slot of histories, copied once and cleared every
+    // batch
+    std::vector <std::vector <Tally> > slot_tally_buffers(HISTORY_SLOTS);
+    for (int slot=0; slot<HISTORY_SLOTS; ++slot)
+        for (int t=0; t<tallies.size(); ++t)
+            slot_tally_buffers[slot].push_back(*tallies[t]);
+
+    // flux of each slot of histories, shaped like the mesh flux
+    mesh.fluxClear();
+    std::vector <FluxArray> slot_flux_buffers(HISTORY_SLOTS);
+    for (int slot=0; slot<HISTORY_SLOTS; ++slot)
+        slot_flux_buffers[slot] = FluxArray(mesh.getFlux());
+
+    // batches before the first active one converge the source only
+    int first_active = settings.getInactiveBatches() + 1;
+    if (settings.getAutoInactive())
+        first_active = num_batches + 1;
+    std::vector <double> entropies;
+
+    // carry on from a checkpoint, or start from its converged source
+    int first_batch = 1;
+    std::vector <Tally*> saved_tallies(tallies.begin(),
+            tallies.begin() + num_saved_tallies);
+    saved_tallies.push_back(&k_tally);
+    if (settings.getRestartFile() != "") {
+        int last_batch;
+        if (!readCheckpoint(settings.getRestartFile(), n_histories,
+                    &last_batch, &first_active, fission_banks, entropies,
+                    k_samples, saved_tallies, mesh, cmfd))
+            exit(1);
+        first_batch = last_batch + 1;
+        first_round = false;
+        if (k_samples.size() > 0)
+            combineEstimates(k_samples, &combined_k, &combined_k_error);
+        if (master) {
+            std::cout << "Resuming from batch " << last_batch << " of "
+                << settings.getRestartFile() << std::endl;
+        }
+    }
+    else if (settings.getSourceFile() != "") {
+        if (!readCheckpointSource(settings.getSourceFile(), fission_banks))
+            exit(1);
+        first_round = false;
+    }
+
+    // neutrons in the cells of a geometry are surface tracked history by
+    // history
+    Geometry* geometry = settings.getGeometry();
+    TransportMode transport_mode = settings.getTransportMode();
+    if (geometry != NULL && master) {
+        if (transport_mode != HISTORY_BASED)
+            std::cout << "Transporting neutrons history by history through "
+                << "the geometry" << std::endl;
+        if (settings.getDeltaTracking())
+            std::cout << "Surface tracking neutrons through the geometry"
+                << std::endl;
+    }
+    if (geometry != NULL)
+        transport_mode = HISTORY_BASED;
+
+    // neutrons split in weight windows are followed one history at a time
+    if (settings.getWeightWindows() != NULL
+            && transport_mode != HISTORY_BASED) {
+        if (master) {
+            std::cout << "Transporting neutrons history by history to split "
+                << "them in weight windows" << std::endl;
+        }
+        transport_mode = HISTORY_BASED;
+    }
+
+    // neutrons transported event by event are always surface tracked
+    if (settings.getDeltaTracking() && geometry == NULL
+            && transport_mode != HISTORY_BASED && master) {
+        std::cout << "Surface tracking neutrons transported event by event"
+            << std::endl;
+    }
+
+    // choose the groups to delta track, skipping those where most
+    // tentative collisions would be virtual
+    std::vector <bool> delta_tracking_groups(num_groups, false);
+    if (settings.getDeltaTracking() && geometry == NULL
+            && transport_mode == HISTORY_BASED) {
+        mesh.computeMajorants();
+        for (int g=0; g<num_groups; ++g) {
+            delta_tracking_groups[g] = mesh.getMajorantRatio(g)
+                >= settings.getMajorantRatioLimit();
+            if (master) {
+                std::cout << "Group " << g << " majorant ratio = "
+                    << mesh.getMajorantRatio(g) << ", using "
+                    << (delta_tracking_groups[g] ? "delta" : "surface")
+                    << " tracking" << std::endl;
+            }
+        }
+    }
 
-        // clear flux data
-        mesh.fluxClear();
+    for (int batch=first_batch; batch <= num_batches; ++batch) {
+        bool active = batch >= first_active;
 
-        // assign new fission locations to old fission locations
-        fission_banks.newBatch();
+        // assign new fission locations to old fission locations, combing
+        // them into one site per history for population control
+        if (settings.getPopulationControl() && !first_round) {
+            RandomStream comb_stream(settings.getSeed(), batch, COMB_STREAM);
+            fission_banks.newBatch(n_histories, first_history, last_history,
+                    comb_stream);
+        }
+        else {
+            fission_banks.newBatch();
+        }
 
-        // clear tallies for leaks absorptions and fissions
-        tallies[LEAKS].clear();
-        tallies[ABSORPTIONS].clear();
-        tallies[FISSIONS].clear();
+        // with no fission sites to start from, sample the source uniformly
+        // as in the first batch
+        if (!first_round && fission_banks.getGlobalSize() == 0) {
+            if (master) {
+                std::cout << "No source sites, sampling the source uniformly"
+                    << std::endl;
+            }
+            first_round = true;
+        }
 
-        // simulate neutron behavior
-        for (int i=0; i<n_histories; ++i) {
-            transportNeutron(bounds, tallies, first_round, mesh, &fission_banks,
-                    num_groups, i);
+        // clear the fission sites of every thread, including any that sat
+        // out the last batch
+        for (int thread=0; thread<max_threads; ++thread) {
+            thread_site_buffers[thread].clear();
+            thread_history_buffers[thread].clear();
         }
 
+        // simulate neutron behavior, each slot of histories accumulating
+        // into its own tallies and flux array and each thread into its own
+        // fission site buffer
+        int rank_histories = last_history - first_history;
+        #pragma omp parallel
+        {
+            int thread = 0;
+#ifdef _OPENMP
+            thread = omp_get_thread_num();
+#endif
+            std::vector <double> &thread_sites = thread_site_buffers[thread];
+            std::vector <int> &thread_site_histories
+                = thread_history_buffers[thread];
+            std::vector <Neutron> &thread_split_neutrons
+                = thread_split_buffers[thread];
+
+            // histories vary greatly in length so hand out the slots
+            // dynamically; each slot is summed by one thread in history
+            // order, so its sums do not depend on the number of threads
+            #pragma omp for schedule(dynamic, 1)
+            for (int slot=0; slot<HISTORY_SLOTS; ++slot) {
+                FluxArray &slot_flux = slot_flux_buffers[slot];
+                std::vector <Tally> &slot_tallies = slot_tally_buffers[slot];
+                slot_flux.clear();
+                for (int t=0; t<tallies.size(); ++t)
+                    slot_tallies[t].clear();
+                int first = first_history
+                    + (long) rank_histories * slot / HISTORY_SLOTS;
+                int last = first_history
+                    + (long) rank_histories * (slot + 1) / HISTORY_SLOTS;
+                if (transport_mode == HISTORY_BASED) {
+                    for (int i=first; i<last; ++i) {
+                        transportNeutron(bounds, slot_tallies, first_round,
+                                mesh, geometry, cmfd, &fission_banks, i,
+                                slot_flux, thread_sites,
+                                thread_site_histories, thread_split_neutrons,
+                                delta_tracking_groups, batch,
+                                settings.getSeed(), settings);
+                    }
+                }
+
+                // advance the slot's histories event by event
+                else {
+                    transportNeutronsEventBased(bounds, slot_tallies,
+                            first_round, mesh, cmfd, &fission_banks, first,
+                            last, slot_flux, thread_sites,
+                            thread_site_histories, batch, settings.getSeed(),
+                            settings);
+                }
+            }
+        }
+
+        // merge the results of the slots in slot order and gather the
+        // fission sites of every thread
+        batch_sites.clear();
+        batch_site_histories.clear();
+        for (int slot=0; slot<HISTORY_SLOTS; ++slot) {
+            for (int t=0; t<tallies.size(); ++t)
+                tallies[t]->merge(slot_tally_buffers[slot][t]);
+            if (active)
+                mesh.fluxReduce(slot_flux_buffers[slot]);
+        }
+        for (int thread=0; thread<max_threads; ++thread) {
+            batch_sites.insert(batch_sites.end(),
+                    thread_site_buffers[thread].begin(),
+                    thread_site_buffers[thread].end());
+            batch_site_histories.insert(batch_site_histories.end(),
+                    thread_history_buffers[thread].begin(),
+                    thread_history_buffers[thread].end());
+        }
+
+        // sum the batch results over all processes
+        for (int t=0; t<tallies.size(); ++t)
+            reduceTally(*tallies[t]);
+        for (int e=0; e<NUM_K_ESTIMATORS; ++e)
+            k[e] = event_tally.getBatchValue(TRACK_LENGTH_K + e) / n_histories;
+        if (cmfd != NULL)
+            cmfd->accumulate();
+
+        // keep the tallies, flux and k of active batches only
+        for (int t=0; t<tallies.size(); ++t) {
+            if (active)
+                tallies[t]->endBatch();
+            else
+                tallies[t]->clear();
+        }
+        if (active) {
+            reduceFlux(mesh);
+            mesh.fluxEndBatch();
+            for (int e=0; e<NUM_K_ESTIMATORS; ++e)
+                k_tally.add(e, k[e]);
+            k_tally.endBatch();
+            k_samples.push_back(k);
+            combineEstimates(k_samples, &combined_k, &combined_k_error);
+        }
+
+        // bank fission sites in history order so the next batch does not
+        // depend on the number of threads or the order they finished in
+        sortSitesByHistory(batch_sites, batch_site_histories, site_order,
+                sorted_sites);
+        for (long i=0; i<batch_sites.size(); i+=SITE_SIZE) {
+            fission_banks.add(&batch_sites[i]);
+        }
+
+        // pull the source of inactive batches toward the coarse mesh one
+        bool cmfd_solved = cmfd != NULL && cmfd->solve();
+        if (cmfd_solved && !active)
+            cmfd->reweightSites(fission_banks.getBankedSites());
+
+        // measure how spread out the new source is
+        double entropy = fission_banks.getEntropy(bounds,
+                settings.getEntropyMesh());
+        entropies.push_back(entropy);
+
         // give results
-        double k = tallies[FISSIONS].getCount() /
-            (tallies[LEAKS].getCount() + tallies[ABSORPTIONS].getCount());
-        double sumStandardDev = tallies[LEAKS].getStandardDeviation(n_histories)
-            + tallies[FISSIONS].getStandardDeviation(n_histories)
-            + tallies[ABSORPTIONS].getStandardDeviation(n_histories);
-        std::cout << "For batch " << batch << ", k = " << k
-            << " with standard deviation of " << sumStandardDev << std::endl;
+        if (master) {
+            std::cout << "For batch " << batch << ", k = " << k[0] << " / "
+                << k[1] << " / " << k[2] << ", entropy = " << entropy;
+            if (cmfd_solved)
+                std::cout << ", CMFD k = " << cmfd->getK();
+            if (active) {
+                std::cout << ", combined k = " << combined_k << " +/- "
+                    << combined_k_error;
+            }
+            else {
+                std::cout << " (inactive)";
+            }
+            std::cout << std::endl;
+        }
         first_round = false;
+
+        // end the inactive phase once the source has converged
+        if (!active && settings.getAutoInactive()
+                && batch >= settings.getInactiveBatches()
+                && entropyConverged(entropies, settings.getEntropyWindow())) {
+            first_active = batch + 1;
+            if (master) {
+                std::cout << "Source entropy converged after " << batch
+                    << " inactive batches" << std::endl;
+            }
+        }
+
+        // save the state of the run
+        int interval = settings.getCheckpointInterval();
+        if (interval > 0 && (batch % interval == 0 || batch == num_batches)) {
+            writeCheckpoint(settings.getCheckpointFile(), n_histories, batch,
+                    first_active, fission_banks, entropies, k_samples,
+                    saved_tallies, mesh, cmfd);
+        }
+    }
+
+    if (first_active > num_batches) {
+        if (master) {
+            std::cout << "No active batches were run" << std::endl;
+        }
+        return;
+    }
+    double mean_crow_distance = event_tally.getMean(CROWS)
+        / event_tally.getMean(NUM_CROWS);
+    if (master) {
+        const char* estimator_names[NUM_K_ESTIMATORS] =
+            {"Track-length", "Collision", "Absorption"};
+        for (int e=0; e<NUM_K_ESTIMATORS; ++e) {
+            std::cout << estimator_names[e] << " k = " << k_tally.getMean(e)
+                << " +/- " << k_tally.getStandardError(e) << std::endl;
+        }
+        std::cout << "Combined k = " << combined_k << " +/- "
+            << combined_k_error << " over " << k_tally.getNumBatches()
+            << " active batches" << std::endl;
+        std::cout << "Mean crow fly distance = " << mean_crow_distance
+            << std::endl;
+    }
+}
+
+/*
+ @brief     samples the starting point, direction, cell and energy group of
+            a source neutron
+ @param     neutron the neutron to be set up
+ @param     bounds a Boundaries object containing the limits
+            of the bounding box
+ @param     first_round whether the source is sampled uniformly in the
+            bounding box (true) or from the fission bank (false); a rank
+            holding no fission sites samples uniformly either way
+ @param     mesh a Mesh object containing information about the mesh
+ @param     geometry the cells the neutron is tracked through, or NULL if it
+            is tracked through the mesh
+ @param     fission_banks containing the old fission bank to sample from
+ @param     neutron_starting_point an array of three coordinates to fill with
+            the starting point of the neutron
+*/
+void sampleSourceNeutron(Neutron &neutron, Boundaries &bounds,
+        bool first_round, Mesh &mesh, Geometry* geometry,
+        Fission* fission_banks, double* neutron_starting_point) {
+    
+    // new way to sample neutron and set its direction
+    neutron.sampleDirection();
+     
+    // get and set neutron starting poinit, uniformly if this rank holds no
+    // fission sites
+    bool uniform = first_round || !fission_banks->sampleSite(&neutron,
+            neutron_starting_point);
+    if (uniform) {
+        bounds.sampleLocation(&neutron, neutron_starting_point);
+    }
+    neutron.setPositionVector(neutron_starting_point);
+    
+    // get mesh cell
+    int cell[3];
+    mesh.getCell(neutron_starting_point, neutron.getDirectionVector(), cell);
+    neutron.setCell(cell);
+
+    // get geometry cells, resampling uniform sources outside every cell
+    Material* cell_mat;
+    if (geometry != NULL) {
+        CellPath* path = neutron.getCellPath();
+        bool found = geometry->findCell(neutron_starting_point,
+                neutron.getDirectionVector(), path);
+        for (int tries=1; !found && uniform && tries<MAX_SOURCE_TRIES;
+                ++tries) {
+            bounds.sampleLocation(&neutron, neutron_starting_point);
+            neutron.setPositionVector(neutron_starting_point);
+            found = geometry->findCell(neutron_starting_point,
+                    neutron.getDirectionVector(), path);
+        }
+        if (!found) {
+            neutron.kill();
+            cell_mat = mesh.getMaterial(cell);
+        }
+        else {
+            mesh.getCell(neutron_starting_point,
+                    neutron.getDirectionVector(), cell);
+            neutron.setCell(cell);
+            cell_mat = path->material;
+        }
+    }
+    else {
+        cell_mat = mesh.getMaterial(cell);
+    }
+
+    // set neutron group
+    int group;
+    group = cell_mat->sampleChiGroup(&neutron);
+    neutron.setGroup(group);
+}
+
+/*
+ @brief     transports a range of neutron histories event by event
+ @details   the source neutrons are loaded into a ParticleBank and advanced
+            together one stage at a time: distance sampling, distance to the
+            nearest cell surface, moving and tallying, surface crossing and
+            collision. The results are statistically equivalent to running
+            transportNeutron() on each history.
+ @param     bounds a Boundaries object containing the limits
+            of the bounding box
+ @param     tallies a vector of the event tally of crow distances,
+            leakages, absorptions and fissions, then the tallies to score
+            track lengths in, ending with the coarse mesh tally if cmfd is
+            set
+ @param     first_round whether the source is sampled uniformly in the
+            bounding box (true) or from the fission bank (false)
+ @param     mesh a Mesh object containing information about the mesh
+ @param     cmfd the coarse mesh to score, or NULL for none
+ @param     fission_banks containing the old fission bank to sample from
+ @param     first_history the first history number to transport
+ @param     last_history one past the last history number to transport
+ @param     flux a flux array to add track lengths to
+ @param     fission_sites a buffer of new fission sites, SITE_SIZE values
+            per site
+ @param     site_histories the history number of each site in fission_sites
+ @param     batch the batch number
+ @param     seed the global random number seed
+ @param     settings a Settings object containing the survival biasing
+            options
+*/
+void transportNeutronsEventBased(Boundaries &bounds,
+        std::vector <Tally> &tallies, bool first_round, Mesh &mesh,
+        Cmfd* cmfd, Fission* fission_banks, int first_history,
+        int last_history, FluxArray &flux,
+        std::vector <double> &fission_sites,
+        std::vector <int> &site_histories, int batch, uint64_t seed,
+        Settings &settings) {
+
+    // load source neutrons into the bank
+    ParticleBank bank(last_history - first_history);
+    for (int i=first_history; i<last_history; ++i) {
+        Neutron neutron(i, batch, seed);
+        double neutron_starting_point[3];
+        sampleSourceNeutron(neutron, bounds, first_round, mesh, NULL,
+                fission_banks, neutron_starting_point);
+        bank.add(neutron, i);
+    }
+
+    // advance every live neutron one event at a time
+    while (bank.size() > 0) {
+        bank.sampleDistances(mesh);
+        bank.findBoundaryDistances(mesh);
+        bank.moveAndTally(mesh, cmfd, tallies, flux);
+        bank.crossSurfaces(bounds, mesh, cmfd, tallies);
+        bank.collide(mesh, tallies, fission_sites, site_histories,
+                settings.getSurvivalBiasing(), settings.getWeightCutoff(),
+                settings.getSurvivalWeight());
+        bank.removeDead(tallies);
     }
-    double mean_crow_distance = tallies[CROWS].getCount()
-        / tallies[NUM_CROWS].getCount();
-    std::cout << "Mean crow fly distance = " << mean_crow_distance << std::endl;
 }
 
 /*
@@ -74,241 +559,671 @@ void generateNeutronHistories(int n_histories, Boundaries bounds,
             is appended to crow_distances. If the absorption creates
             a fission event, the number of neutrons emited is sampled.
             The location of the fission event is added to a list of fission
-            events.
+            events. With survival biasing the neutron is never absorbed:
+            each collision scores the absorbed part of its weight and banks
+            the fission neutrons expected from it. With weight windows the
+            neutron is split or rouletted at collisions and mesh surface
+            crossings, and the neutrons split off it are followed in turn
+            once it dies.
  @param     bounds a Boundaries object containing the limits
             of the bounding box
- @param     tallies a dictionary containing tallies of crow distances,
-            leakages, absorptions, and fissions
+ @param     tallies a vector of the event tally of crow distances,
+            leakages, absorptions and fissions, then the tallies to score
+            track lengths in
  @param     mesh a Mesh object containing information about the mesh
- @param     old_fission_banks containing the old fission bank
- @param     new_fission_banks containing the new fission bank
- @param     num_groups the number of neutron energy groups
+ @param     geometry the cells to track the neutron through, or NULL to
+            track it through the mesh
+ @param     cmfd the coarse mesh to score in the last of the tallies, or
+            NULL for none
+ @param     fission_banks containing the old fission bank to sample from
+ @param     neutron_num the history number, which picks the neutron's
+            random number stream
+ @param     flux the flux array of the history's slot to add track lengths to
+ @param     fission_sites a thread-private buffer of new fission sites,
+            SITE_SIZE values per site
+ @param     site_histories the history number of each site in fission_sites
+ @param     split_neutrons a thread-private stack for the neutrons split off
+            the history, with room reserved for MAX_SPLIT_NEUTRONS
+ @param     delta_tracking_groups whether each energy group is delta tracked
+ @param     batch the batch number
+ @param     seed the global random number seed
+ @param     settings a Settings object containing the survival biasing
+            and weight window options
 */
 void transportNeutron(Boundaries bounds, std::vector <Tally> &tallies,
-        bool first_round, Mesh &mesh, Fission* fission_banks, int num_groups,
-        int neutron_num) {
-    const double TINY_MOVE = 1e-10;
-    
-    // new way to sample neutron and set its direction
-    Neutron neutron(neutron_num);
-    neutron.sampleDirection();
-     
-    // get and set neutron starting poinit
-    std::vector <double> neutron_starting_point;
-    if (first_round)
-        neutron_starting_point = bounds.sampleLocation(&neutron);
-    else
-        neutron_starting_point = fission_banks->sampleSite(&neutron);
-    neutron.setPositionVector(neutron_starting_point);
+        bool first_round, Mesh &mesh, Geometry* geometry, Cmfd* cmfd,
+        Fission* fission_banks, int neutron_num, FluxArray &flux,
+        std::vector <double> &fission_sites,
+        std::vector <int> &site_histories,
+        std::vector <Neutron> &split_neutrons,
+        std::vector <bool> &delta_tracking_groups, int batch, uint64_t seed,
+        Settings &settings) {
     
-    // get mesh cell
-    std::vector <double> neutron_direction;
-    neutron_direction = neutron.getDirectionVector();
-    std::vector <int> cell;
-    cell = mesh.getCell(neutron_starting_point, neutron_direction);
-    neutron.setCell(cell);
-
-    // set neutron group
+    // sample the neutron's starting point, direction, cell and group
+    Neutron neutron(neutron_num, batch, seed);
+    double neutron_starting_point[3];
+    sampleSourceNeutron(neutron, bounds, first_round, mesh, geometry,
+            fission_banks, neutron_starting_point);
+    double* neutron_position = neutron.getPositionVector();
+    int* cell = neutron.getCell();
     Material* cell_mat;
     int group;
-    cell_mat = mesh.getMaterial(cell);
-    std::vector <double> chi(num_groups);
-    for (int g=0; g<num_groups; ++g) {
-        chi[g] = cell_mat->getChi(g);
-    }
-    group = neutron.sampleNeutronEnergyGroup(chi);
-    neutron.setGroup(group);
-    
-    // follow neutron while it's alive
-    while (neutron.alive()) {
+    bool survival_biasing = settings.getSurvivalBiasing();
+    WeightWindows* weight_windows = settings.getWeightWindows();
+    split_neutrons.clear();
 
-        cell_mat = mesh.getMaterial(cell);
-        group = neutron.getGroup();
-        double neutron_distance;
-        neutron_distance = cell_mat->sampleDistance(group, &neutron);
-        std::vector <double> neutron_position;
+    // follow the neutron, then each neutron split off the history
+    while (true) {
+
+        // leave room to bank the fission neutrons of the collisions to come
+        if (fission_sites.capacity() - fission_sites.size()
+                < SITE_SIZE * SITE_HEADROOM) {
+            fission_sites.reserve(2 * fission_sites.capacity()
+                    + SITE_SIZE * SITE_HEADROOM);
+            site_histories.reserve(2 * site_histories.capacity()
+                    + SITE_HEADROOM);
+        }
+
+#ifdef DEBUG
+        // nothing from here until the neutron dies should touch the heap,
+        // unless it banks more fission neutrons than there is room for
+        long allocations = getAllocationCount();
+        long site_capacity = fission_sites.capacity();
+#endif
     
-        // track neutron until collision or leakage
-        while (neutron_distance > 0) {
-            neutron_position = neutron.getPositionVector();
-
-            // get cell boundaries
-            std::vector <double> cell_mins;
-            std::vector <double> cell_maxes;
-            cell_mins = mesh.getCellMin(cell);
-            cell_maxes = mesh.getCellMax(cell);
-
-            // calculate distances to cell boundaries
-            std::vector <std::vector <double> > distance_to_cell_edge(3);
-            for (int axis=0; axis<3; ++axis) {
-                distance_to_cell_edge[axis].resize(2);
-                distance_to_cell_edge[axis][0] =
-                    cell_mins[axis] - neutron.getPosition(axis);
-                distance_to_cell_edge[axis][1] =
-                    cell_maxes[axis] - neutron.getPosition(axis);
+        // follow neutron while it's alive
+        while (neutron.alive()) {
+
+            // move the neutron to its next collision site
+            group = neutron.getGroup();
+            if (geometry != NULL) {
+                geometryTrackNeutron(neutron, mesh, geometry, tallies, flux);
+            }
+            else if (delta_tracking_groups[group]) {
+                deltaTrackNeutron(neutron, bounds, mesh, tallies, flux);
+            }
+            else {
+                surfaceTrackNeutron(neutron, bounds, mesh, cmfd,
+                        weight_windows, tallies, flux, split_neutrons);
             }
 
-            // tempd contains the current smallest r
-            double tempd;
-            tempd = neutron_distance;
+            // check interaction
+            if (neutron.alive()) {
+                if (geometry != NULL)
+                    cell_mat = neutron.getCellPath()->material;
+                else
+                    cell_mat = mesh.getMaterial(cell);
+                double weight = neutron.getWeight();
+                double nu_sigma_f = cell_mat->getNu()
+                    * cell_mat->getSigmaF(group);
+                tallies[EVENT_TALLY].add(COLLISION_K,
+                        weight * nu_sigma_f / cell_mat->getSigmaT(group));
 
-            // create lim_bounds
-            std::vector <int> cell_lim_bound;
-            std::vector <int> box_lim_bound;
-           
-            // clear lim_bounds
-            cell_lim_bound.clear();
-            box_lim_bound.clear();
-
-            // test each boundary
-            double r;
-            for (int axis=0; axis<3; ++axis) {
-                for (int side=0; side<2; ++side) {
-
-                    // r is variable that contains the distance
-                    // along the direction vector to the boundary being tested.
-                    r = distance_to_cell_edge[axis][side]
-                        / neutron.getDirection(axis);
-                    if (r > 0 & r < tempd) {
-                        tempd = r;
-                        cell_lim_bound.clear();
-                        cell_lim_bound.push_back(axis*2+side);
-                    }
-                    else if (r == tempd) {
-                        cell_lim_bound.push_back(axis*2+side);
+                // sample what the interaction will be. A survival biased
+                // neutron scores the absorbed part of its weight and
+                // scatters.
+                int neutron_interaction;
+                int num_fission_neutrons = 0;
+                if (survival_biasing) {
+                    double absorbed = weight * cell_mat->getSigmaA(group)
+                        / cell_mat->getSigmaT(group);
+                    double production = weight * nu_sigma_f
+                        / cell_mat->getSigmaT(group);
+                    tallies[EVENT_TALLY].add(ABSORPTIONS, absorbed);
+                    tallies[EVENT_TALLY].add(ABSORPTION_K, production);
+
+                    if (production > 0.0) {
+                        num_fission_neutrons = (int) (production
+                                + neutron.arand());
                     }
+                    neutron.setWeight(weight - absorbed);
+                    neutron_interaction = 0;
+                }
+                else {
+                    neutron_interaction = cell_mat->sampleInteraction(group,
+                            &neutron);
                 }
-            }
 
-            // move neutron
-            neutron.move(tempd);
-
-            // add distance to cell flux
-            mesh.fluxAdd(cell, tempd, group);
-
-            // determine boundary status
-            for (int sur_side=0; sur_side <6; ++sur_side) {
-                int axis = sur_side/2;
-                int side = sur_side%2;
-
-                // if sur_side is in cell_lim_bound
-                if (std::find(cell_lim_bound.begin(),
-                            cell_lim_bound.end(),sur_side)
-                        != cell_lim_bound.end()) {
-                    if (cell_mins[axis] == bounds.getSurfaceCoord(axis, side)
-                            | cell_maxes[axis] == 
-                            bounds.getSurfaceCoord(axis, side)) {
-                        box_lim_bound.push_back(sur_side);
-                    }
+
+                // scattering event
+                if (neutron_interaction == 0) {
+
+                    // sample scattered direction
+                    neutron.sampleDirection();
+
+                    // sample new energy group
+                    int new_group;
+                    new_group = cell_mat->sampleScatteredGroup(group,
+                            &neutron);
+
+                    // set new group
+                    neutron.setGroup(new_group);
                 }
-            }
 
-            // check boundary conditions on all hit surfaces
-            for (int sur_side=0; sur_side <6; ++sur_side) {
-                int axis = sur_side/2;
-                int side = sur_side%2;
-
-                // if sur_side is in box_lim_bound
-                if (std::find(box_lim_bound.begin(),
-                            box_lim_bound.end(),sur_side)
-                        != box_lim_bound.end()) {
-
-                    // if the neutron is reflected
-                    if (bounds.getSurfaceType(axis, side) == 1) {
-                        neutron.reflect(axis);
-
-                        // place neutron on boundary to eliminate 
-                        //    roundoff error
-                        double bound_val;
-                        bound_val = bounds.getSurfaceCoord(axis, side);
-                        neutron.setPosition(axis, bound_val);
-                    }
+                // absorption event
+                else {
 
-                    // if the neutron escapes
-                    if (bounds.getSurfaceType(axis, side) == 0) {
-                        neutron.kill();
-                        neutron_distance = tempd;
-                        tallies[LEAKS] += 1;
+                    // tally absorption
+                    tallies[EVENT_TALLY].add(ABSORPTIONS, weight);
+                    tallies[EVENT_TALLY].add(ABSORPTION_K,
+                            weight * nu_sigma_f / cell_mat->getSigmaA(group));
+
+                    // sample for fission event
+                    group = neutron.getGroup();
+
+                    // fission event, sampling the number of neutrons once.
+                    // A neutron not of unit weight banks its weight times
+                    // the number sampled in expectation.
+                    if (cell_mat->sampleFission(group, &neutron) == 1) {
+                        num_fission_neutrons
+                            = cell_mat->sampleNumFission(&neutron);
+                        if (weight != 1.0) {
+                            num_fission_neutrons = (int) (weight
+                                    * num_fission_neutrons + neutron.arand());
+                        }
                     }
+
+                    // end neutron history
+                    neutron.kill();
                 }
-            }
- 
-            // shorten neutron distance to collision
-            neutron_distance -= tempd;
-
-            // get new neutron cell
-            if (neutron_distance > 0.0) {
-                neutron_direction = neutron.getDirectionVector();
-                cell = mesh.getCell(neutron_position, neutron_direction);
-
-                // nudge neutron and find its cell
-                neutron.move(TINY_MOVE);
-                neutron_position = neutron.getPositionVector();
-                if (mesh.positionInBounds(neutron_position)) {
-                    cell = mesh.getCell(neutron_position, neutron_direction);
+
+                // bank the fission neutrons at the collision site
+                for (int i=0; i<num_fission_neutrons; ++i) {
+                    for (int axis=0; axis<3; ++axis)
+                        fission_sites.push_back(neutron_position[axis]);
+                    fission_sites.push_back(1.0);
+                    site_histories.push_back(neutron_num);
+                    tallies[EVENT_TALLY].add(FISSIONS, 1.0);
+                }
+
+                // keep the neutron in the weight window of its cell and new
+                // group, or roulette survival biased neutrons of low weight
+                // where there is no window
+                bool windowed = weight_windows != NULL && neutron.alive()
+                    && weight_windows->apply(neutron, split_neutrons);
+                if (survival_biasing && !windowed) {
+                    rouletteNeutron(neutron, settings.getWeightCutoff(),
+                            settings.getSurvivalWeight());
                 }
-                neutron.move(-TINY_MOVE);
-                neutron.setCell(cell);
             }
         }
 
-        // check interaction
-        if (neutron.alive()) {
-            cell_mat = mesh.getMaterial(cell);
+#ifdef DEBUG
+        assert(getAllocationCount() == allocations
+                || fission_sites.capacity() != site_capacity);
+#endif
 
-            // sample what the interaction will be
-            int neutron_interaction;
-            neutron_interaction = cell_mat->sampleInteraction(group, &neutron);
+        // tally crow distance, then move on to the next split neutron
+        double crow_distance;
+        crow_distance = neutron.getDistance(neutron_starting_point);
+        tallies[EVENT_TALLY].add(CROWS, crow_distance);
+        tallies[EVENT_TALLY].add(NUM_CROWS, 1.0);
 
+        if (split_neutrons.empty())
+            break;
+        neutron = split_neutrons.back();
+        split_neutrons.pop_back();
+    }
+}
 
-            // scattering event
-            if (neutron_interaction == 0) {
+/*
+ @brief     plays Russian roulette with a neutron whose weight has fallen
+            below the cutoff, killing it or raising its weight so that its
+            expected weight is unchanged
+ @param     neutron the neutron
+ @param     weight_cutoff the weight below which the neutron plays
+ @param     survival_weight the weight the neutron takes if it survives
+*/
+void rouletteNeutron(Neutron &neutron, double weight_cutoff,
+        double survival_weight) {
+    double weight = neutron.getWeight();
+    if (weight >= weight_cutoff)
+        return;
+    if (neutron.arand() * survival_weight < weight)
+        neutron.setWeight(survival_weight);
+    else
+        neutron.kill();
+}
 
-                // sample scattered direction
-                neutron.sampleDirection();
+/*
+ @brief     moves a neutron to its next collision site by sampling a
+            distance in the material of its cell and walking it through the
+            mesh surface by surface, adding its track length to the flux
+ @details   the neutron is killed and counted as a leak if it escapes
+            through a vacuum boundary. With weight windows it is split or
+            rouletted in each new cell it enters, and its split copies start
+            their flights from the surface.
+ @param     neutron a neutron with its position, direction, cell and
+            group set
+ @param     bounds a Boundaries object containing the limits
+            of the bounding box
+ @param     mesh a Mesh object containing information about the mesh
+ @param     cmfd the coarse mesh to score in the last of the tallies, or
+            NULL for none
+ @param     weight_windows the weight windows of the mesh cells, or NULL for
+            none
+ @param     tallies a vector of tallies in which to count leaks, score
+            track lengths and count mesh surface crossings
+ @param     flux a flux array to add track lengths to
+ @param     split_neutrons the stack to push neutrons split off this one
+            onto
+*/
+void surfaceTrackNeutron(Neutron &neutron, Boundaries &bounds, Mesh &mesh,
+        Cmfd* cmfd, WeightWindows* weight_windows,
+        std::vector <Tally> &tallies, FluxArray &flux,
+        std::vector <Neutron> &split_neutrons) {
+    int* cell = neutron.getCell();
+    Material* cell_mat = mesh.getMaterial(cell);
+    int group = neutron.getGroup();
+    double weight = neutron.getWeight();
+    double neutron_distance;
+    neutron_distance = cell_mat->sampleDistance(group, &neutron);
+
+    // distance to the next cell surface along each axis
+    double crossings[3];
+    mesh.getCrossingDistances(&neutron, crossings);
+    
+    // track neutron until collision or leakage
+    while (neutron_distance > 0) {
+
+        // tempd contains the distance to the nearest cell surface or the
+        // collision site, whichever is closer
+        double tempd;
+        tempd = neutron_distance;
+        for (int axis=0; axis<3; ++axis) {
+            if (crossings[axis] < tempd)
+                tempd = crossings[axis];
+        }
 
-                // sample new energy group
-                int new_group;
-                std::vector <double> temp_sigma_s_group;
-                temp_sigma_s_group = cell_mat->getSigmaS(group);
-                new_group = neutron.sampleScatteredGroup(temp_sigma_s_group,
-                        group);
+        // add distance to cell flux, tallies and the track-length k
+        mesh.fluxAddTrack(cell, neutron.getPositionVector(),
+                neutron.getDirectionVector(), tempd, weight, group, flux);
+        scoreTallies(tallies, cell, group, cell_mat, tempd * weight);
+        tallies[EVENT_TALLY].add(TRACK_LENGTH_K, tempd * weight
+                * cell_mat->getNu() * cell_mat->getSigmaF(group));
+        if (cmfd != NULL) {
+            cmfd->score(tallies.back(), cell, group, cell_mat,
+                    tempd * weight);
+        }
 
-                // set new group
-                neutron.setGroup(new_group);
+        // move neutron
+        neutron.move(tempd);
+
+        // shorten neutron distance to collision
+        neutron_distance -= tempd;
+        if (neutron_distance <= 0.0)
+            break;
+
+        // cross every surface reached, so edges and corners step
+        // through all of their axes at once
+        for (int axis=0; axis<3; ++axis) {
+            crossings[axis] -= tempd;
+            if (crossings[axis] > CROSSING_TOLERANCE)
+                continue;
+            int side = neutron.getDirection(axis) > 0.0 ? MAX : MIN;
+            scoreCrossingTallies(tallies, cell, axis, side,
+                    neutron.getDirection(axis), group, cell_mat, weight);
+            if (cmfd != NULL) {
+                cmfd->scoreCrossing(tallies.back(), cell, axis,
+                        (min_max) side, group, weight);
+            }
+            if (mesh.crossSurface(&neutron, axis, crossings))
+                continue;
+
+            // the surface is on the edge of the geometry. If the neutron
+            // is reflected, it crosses back into its cell
+            if (bounds.getSurfaceType(axis, side) == REFLECTIVE) {
+                neutron.reflect(axis);
+                scoreCrossingTallies(tallies, cell, axis, side,
+                        neutron.getDirection(axis), group, cell_mat, weight);
             }
 
-            // absorption event
+            // if the neutron escapes
             else {
+                neutron.kill();
+                neutron_distance = 0.0;
+                tallies[EVENT_TALLY].add(LEAKS, weight);
+                break;
+            }
+        }
+        if (!neutron.alive())
+            break;
 
-                // tally absorption
-                tallies[ABSORPTIONS] += 1;
+        // keep the number of mean free paths left to travel if the new cell
+        // is a different material
+        Material* new_mat = mesh.getMaterial(cell);
+        if (new_mat != cell_mat) {
+            neutron_distance *= cell_mat->getSigmaT(group)
+                / new_mat->getSigmaT(group);
+            cell_mat = new_mat;
+        }
 
-                // sample for fission event
-                group = neutron.getGroup();
-                cell = neutron.getCell();
-                cell_mat = mesh.getMaterial(cell);
-                neutron_position = neutron.getPositionVector();
+        // keep the neutron in the weight window of its new cell
+        if (weight_windows != NULL) {
+            weight_windows->apply(neutron, split_neutrons);
+            if (!neutron.alive())
+                break;
+            weight = neutron.getWeight();
+        }
+    }
+}
 
-                // fission event
-                if (cell_mat->sampleFission(group, &neutron) == 1) {
+/*
+ @brief     moves a neutron to its next collision site by sampling a
+            distance in the material of its cell of a Geometry and walking
+            it from cell to cell, adding its track length to the flux
+ @details   the neutron crosses the surfaces of its cells and the edges of
+            lattice elements at every level of universes. Each track
+            between crossings scores the tallies in the mesh cell holding
+            its midpoint. The neutron is killed and counted as a leak if it
+            escapes through a vacuum surface, or if it is lost between cells
+            that do not fill the geometry.
+ @param     neutron a neutron with its position, direction, cell, cell path
+            and group set
+ @param     mesh a Mesh object holding the flux and binning the tallies
+ @param     geometry the root of the cells to track the neutron through
+ @param     tallies a vector of tallies in which to count leaks and score
+            track lengths
+ @param     flux a flux array to add track lengths to
+*/
+void geometryTrackNeutron(Neutron &neutron, Mesh &mesh, Geometry* geometry,
+        std::vector <Tally> &tallies, FluxArray &flux) {
+    int* cell = neutron.getCell();
+    double* position = neutron.getPositionVector();
+    double* direction = neutron.getDirectionVector();
+    CellPath* path = neutron.getCellPath();
+    Material* cell_mat = path->material;
+    int group = neutron.getGroup();
+    double weight = neutron.getWeight();
+    double neutron_distance;
+    neutron_distance = cell_mat->sampleDistance(group, &neutron);
 
-                    // sample number of neutrons
-                    for (int i=0; i<cell_mat->sampleNumFission(&neutron); ++i) {
-                        fission_banks->add(neutron_position);
-                        tallies[FISSIONS] += 1;
-                    }
-                }
+    // track neutron until collision or leakage
+    while (neutron_distance > 0) {
+
+        // tempd contains the distance to the nearest crossing or the
+        // collision site, whichever is closer
+        double tempd = geometry->getBoundaryDistance(path, position,
+                direction);
+        bool collision = neutron_distance < tempd;
+        if (collision)
+            tempd = neutron_distance;
+
+        // add distance to the flux, the tallies of the mesh cell at the
+        // middle of the track and the track-length k
+        mesh.fluxAddTrack(position, direction, tempd, weight, group, flux);
+        double midpoint[3];
+        for (int axis=0; axis<3; ++axis)
+            midpoint[axis] = position[axis] + 0.5 * tempd * direction[axis];
+        mesh.getCell(midpoint, direction, cell);
+        scoreTallies(tallies, cell, group, cell_mat, tempd * weight);
+        tallies[EVENT_TALLY].add(TRACK_LENGTH_K, tempd * weight
+                * cell_mat->getNu() * cell_mat->getSigmaF(group));
+
+        // move neutron
+        neutron.move(tempd);
+        if (collision)
+            break;
+        neutron_distance -= tempd;
+
+        // if the neutron is reflected it stays in its cells
+        Surface* surface = geometry->getCrossingSurface(path);
+        if (surface != NULL && surface->getType() == REFLECTIVE) {
+            double normal[3];
+            geometry->getCrossingNormal(path, position, normal);
+            neutron.reflect(normal);
+            continue;
+        }
+
+        // if the neutron escapes
+        if ((surface != NULL && surface->getType() == VACUUM)
+                || !geometry->crossSurface(path, position, direction)) {
+            neutron.kill();
+            tallies[EVENT_TALLY].add(LEAKS, weight);
+            break;
+        }
 
-                // end neutron history
+        // keep the number of mean free paths left to travel if the new cell
+        // is a different material
+        Material* new_mat = path->material;
+        if (new_mat != cell_mat) {
+            neutron_distance *= cell_mat->getSigmaT(group)
+                / new_mat->getSigmaT(group);
+            cell_mat = new_mat;
+        }
+    }
+
+    // leave the mesh cell where the neutron stopped
+    mesh.getCell(position, direction, cell);
+}
+
+/*
+ @brief     moves a neutron to its next real collision site with Woodcock
+            delta tracking, scoring the collision estimator of the flux
+ @details   flight distances are sampled with the majorant total cross
+            section of the mesh, so no cell surfaces need to be found. At
+            each tentative collision the neutron's cell is looked up and the
+            collision is accepted as real with probability
+            sigma_t / majorant, otherwise it continues in the same direction.
+            Each tentative collision adds weight / majorant to the cell flux,
+            which has the same mean as the track length. The neutron is
+            killed and counted as a leak if it escapes through a vacuum
+            boundary.
+ @param     neutron a neutron with its position, direction, cell and
+            group set
+ @param     bounds a Boundaries object containing the limits
+            of the bounding box
+ @param     mesh a Mesh object containing information about the mesh
+ @param     tallies a vector of tallies in which to count leaks and score
+            collision estimates
+ @param     flux a flux array to add collision estimates to
+*/
+void deltaTrackNeutron(Neutron &neutron, Boundaries &bounds, Mesh &mesh,
+        std::vector <Tally> &tallies, FluxArray &flux) {
+    int* cell = neutron.getCell();
+    int group = neutron.getGroup();
+    double weight = neutron.getWeight();
+    double majorant = mesh.getMajorant(group);
+
+    while (neutron.alive()) {
+        double neutron_distance = -log(neutron.arand()) / majorant;
+
+        // find the nearest edge of the geometry
+        double edge_distance = INFINITY;
+        int edge_axis = 0;
+        int edge_side = MIN;
+        for (int axis=0; axis<3; ++axis) {
+            double direction = neutron.getDirection(axis);
+            if (direction == 0.0)
+                continue;
+            int side = direction > 0.0 ? MAX : MIN;
+            double r = (mesh.getPlane(axis, side * mesh.getAxisSize(axis))
+                    - neutron.getPosition(axis)) / direction;
+            if (r < edge_distance) {
+                edge_distance = r;
+                edge_axis = axis;
+                edge_side = side;
+            }
+        }
+
+        // the flight reaches the edge of the geometry
+        if (edge_distance <= neutron_distance) {
+            neutron.move(edge_distance);
+            neutron.setPosition(edge_axis, mesh.getPlane(edge_axis,
+                        edge_side * mesh.getAxisSize(edge_axis)));
+
+            // if the neutron is reflected
+            if (bounds.getSurfaceType(edge_axis, edge_side) == REFLECTIVE) {
+                neutron.reflect(edge_axis);
+            }
+
+            // if the neutron escapes
+            else {
                 neutron.kill();
+                tallies[EVENT_TALLY].add(LEAKS, weight);
             }
+            continue;
+        }
+
+        // move to the tentative collision site and find its cell
+        neutron.move(neutron_distance);
+        mesh.getCell(neutron.getPositionVector(), neutron.getDirectionVector(),
+                cell);
+        Material* cell_mat = mesh.getMaterial(cell);
+        mesh.fluxAddCollision(cell, neutron.getPositionVector(),
+                neutron.getDirectionVector(), weight / majorant, group, flux);
+        scoreTallies(tallies, cell, group, cell_mat, weight / majorant);
+        tallies[EVENT_TALLY].add(TRACK_LENGTH_K, weight * cell_mat->getNu()
+                * cell_mat->getSigmaF(group) / majorant);
+
+        // accept the collision as real or carry on
+        if (neutron.arand() * majorant < cell_mat->getSigmaT(group))
+            return;
+    }
+}
+
+/*
+ @brief     combines correlated estimates of a quantity into the estimate of
+            least variance
+ @details   with S the covariance matrix of the batch means of the
+            estimators, the combined estimate weights the means by
+            S^-1 1 / (1^T S^-1 1) and its variance is 1 / (1^T S^-1 1).
+            Until there are more batches than estimators S cannot be
+            inverted, and if S is singular the estimators are too closely
+            correlated to combine, so the single estimator of least
+            variance is used instead.
+ @param     samples the estimate of each estimator in each batch
+ @param     mean set to the combined estimate
+ @param     standard_error set to the standard error of the combined
+            estimate
+*/
+void combineEstimates(std::vector <std::vector <double> > &samples,
+        double* mean, double* standard_error) {
+    int num_samples = samples.size();
+    int n = samples[0].size();
+
+    // means of the estimators and the covariance of the means
+    std::vector <double> means(n, 0.0);
+    for (int b=0; b<num_samples; ++b)
+        for (int i=0; i<n; ++i)
+            means[i] += samples[b][i] / num_samples;
+    std::vector <std::vector <double> > covariance(n,
+            std::vector <double>(n, 0.0));
+    if (num_samples > 1) {
+        for (int b=0; b<num_samples; ++b)
+            for (int i=0; i<n; ++i)
+                for (int j=0; j<n; ++j)
+                    covariance[i][j] += (samples[b][i] - means[i])
+                        * (samples[b][j] - means[j])
+                        / ((double) num_samples * (num_samples - 1));
+    }
+
+    // fall back on the best single estimator
+    int best = 0;
+    for (int i=1; i<n; ++i)
+        if (covariance[i][i] < covariance[best][best])
+            best = i;
+    *mean = means[best];
+    *standard_error = sqrt(covariance[best][best]);
+    if (num_samples <= n)
+        return;
+
+    // solve S w = 1 by Gaussian elimination with partial pivoting
+    std::vector <double> weights(n, 1.0);
+    for (int col=0; col<n; ++col) {
+        int pivot = col;
+        for (int row=col+1; row<n; ++row)
+            if (fabs(covariance[row][col]) > fabs(covariance[pivot][col]))
+                pivot = row;
+        if (fabs(covariance[pivot][col]) <= 1e-14 * covariance[best][best])
+            return;
+        std::swap(covariance[col], covariance[pivot]);
+        std::swap(weights[col], weights[pivot]);
+        for (int row=col+1; row<n; ++row) {
+            double factor = covariance[row][col] / covariance[col][col];
+            for (int j=col; j<n; ++j)
+                covariance[row][j] -= factor * covariance[col][j];
+            weights[row] -= factor * weights[col];
         }
     }
+    for (int row=n-1; row>=0; --row) {
+        for (int j=row+1; j<n; ++j)
+            weights[row] -= covariance[row][j] * weights[j];
+        weights[row] /= covariance[row][row];
+    }
+
+    double weight_sum = 0.0;
+    for (int i=0; i<n; ++i)
+        weight_sum += weights[i];
+    if (weight_sum <= 0.0)
+        return;
+    *mean = 0.0;
+    for (int i=0; i<n; ++i)
+        *mean += weights[i] * means[i] / weight_sum;
+    *standard_error = sqrt(1.0 / weight_sum);
+}
 
-    // tally crow distance
-    double crow_distance;
-    crow_distance = neutron.getDistance(neutron_starting_point);
-    tallies[CROWS] += crow_distance;
-    tallies[NUM_CROWS] += 1;
+/*
+ @brief     checks whether the Shannon entropy of the fission source has
+            settled
+ @details   the mean entropy of the last window of batches is compared
+            with the mean of the window before it. The source is taken as
+            converged once the two differ by less than the standard
+            deviation of the entropy over the last window, so the drift
+            left is lost in the batch-to-batch noise.
+ @param     entropies the source entropy of each batch run so far
+ @param     window the number of batches in each window
+ @return    true if the entropy has settled
+*/
+bool entropyConverged(std::vector <double> &entropies, int window) {
+    int num_batches = entropies.size();
+    if (window < 2 || num_batches < 2 * window)
+        return false;
+    double last_mean = 0.0;
+    double previous_mean = 0.0;
+    for (int i=0; i<window; ++i) {
+        last_mean += entropies[num_batches - 1 - i];
+        previous_mean += entropies[num_batches - 1 - window - i];
+    }
+    last_mean /= window;
+    previous_mean /= window;
+    double variance = 0.0;
+    for (int i=0; i<window; ++i) {
+        double difference = entropies[num_batches - 1 - i] - last_mean;
+        variance += difference * difference;
+    }
+    variance /= window - 1;
+    return fabs(last_mean - previous_mean) <= sqrt(variance);
+}
+
+/*
+ @brief     orders fission sites gathered from several threads by the history
+            that produced them
+ @details   sites from the same history keep their relative order, so the
+            result is the bank a serial run would have produced. The scratch
+            buffers are kept by the caller, and sorted_sites is left holding
+            the unsorted sites, so neither allocates once they have grown.
+ @param     sites the fission sites produced during the batch, SITE_SIZE
+            values per site
+ @param     site_histories the history number of each site
+ @param     order scratch buffer for the history and index of each site
+ @param     sorted_sites scratch buffer swapped with sites
+*/
+void sortSitesByHistory(std::vector <double> &sites,
+        std::vector <int> &site_histories,
+        std::vector <std::pair <int, int> > &order,
+        std::vector <double> &sorted_sites) {
+    order.resize(site_histories.size());
+    for (int i=0; i<site_histories.size(); ++i) {
+        order[i] = std::make_pair(site_histories[i], i);
+    }
+    std::sort(order.begin(), order.end());
+    sorted_sites.resize(sites.size());
+    for (int i=0; i<order.size(); ++i) {
+        for (int v=0; v<SITE_SIZE; ++v)
+            sorted_sites[SITE_SIZE*i + v] = sites[SITE_SIZE*order[i].second
+                + v];
+        site_histories[i] = order[i].first;
+    }
+    sites.swap(sorted_sites);
 }
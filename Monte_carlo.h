@@ -14,20 +14,104 @@
 #include <math.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <assert.h>
 
 #include "Tally.h"
 #include "Mesh.h"
+#include "Flux_array.h"
 #include "Neutron.h"
 #include "Fission.h"
+#include "Settings.h"
+#include "Particle_bank.h"
+#include "Cmfd.h"
+#include "Weight_windows.h"
+#include "Allocation_counter.h"
+#include "Parallel.h"
+#include "Checkpoint.h"
 
-enum tally_names {CROWS, NUM_CROWS, LEAKS, ABSORPTIONS, FISSIONS};
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// event scores of the first tally of every run
+enum tally_names {CROWS, NUM_CROWS, LEAKS, ABSORPTIONS, FISSIONS,
+    TRACK_LENGTH_K, COLLISION_K, ABSORPTION_K, NUM_TALLY_NAMES};
+
+/** number of k estimators, scored from TRACK_LENGTH_K on */
+const int NUM_K_ESTIMATORS = 3;
+
+/** position of the tally of crow distances, leakages, absorptions and
+    fissions in the tallies of a run, followed by the tallies in Settings */
+const int EVENT_TALLY = 0;
 enum fission_bank_names {OLD, NEW};
 
+/** number of contiguous slots each process's histories are split into and
+    handed to threads; each slot sums its own tallies and flux, so the
+    results do not depend on the number of threads */
+const int HISTORY_SLOTS = 64;
+
+/** fission sites allocated per history in each fission bank */
+const int FISSION_BANK_CAPACITY = 3;
+
+/** fission sites a thread's site buffer keeps room for before following
+    each neutron, so banking them does not allocate */
+const int SITE_HEADROOM = 64;
+
+/** history number of the random number stream used to comb the fission
+    bank, past any real history */
+const int COMB_STREAM = -1;
+
+/** number of uniform source points tried before giving up on finding one
+    inside a cell of a Geometry */
+const int MAX_SOURCE_TRIES = 1000;
+
 void generateNeutronHistories(int n_histories, Boundaries bounds,
         Mesh &mesh, int num_batches, int num_groups);
 
+void generateNeutronHistories(int n_histories, Boundaries bounds,
+        Mesh &mesh, int num_batches, int num_groups, Settings &settings);
+
+void sampleSourceNeutron(Neutron &neutron, Boundaries &bounds,
+        bool first_round, Mesh &mesh, Geometry* geometry,
+        Fission* fission_banks, double* neutron_starting_point);
+
+void transportNeutronsEventBased(Boundaries &bounds,
+        std::vector <Tally> &tallies, bool first_round, Mesh &mesh,
+        Cmfd* cmfd, Fission* fission_banks, int first_history,
+        int last_history, FluxArray &flux,
+        std::vector <double> &fission_sites,
+        std::vector <int> &site_histories, int batch, uint64_t seed,
+        Settings &settings);
+
 void transportNeutron(Boundaries bounds, std::vector <Tally> &tallies,
-        bool first_round, Mesh &mesh, Fission* fission_banks, int num_groups,
-        int neutron_num);
+        bool first_round, Mesh &mesh, Geometry* geometry, Cmfd* cmfd,
+        Fission* fission_banks, int neutron_num, FluxArray &flux,
+        std::vector <double> &fission_sites,
+        std::vector <int> &site_histories,
+        std::vector <Neutron> &split_neutrons,
+        std::vector <bool> &delta_tracking_groups, int batch, uint64_t seed,
+        Settings &settings);
+
+void rouletteNeutron(Neutron &neutron, double weight_cutoff,
+        double survival_weight);
+
+void surfaceTrackNeutron(Neutron &neutron, Boundaries &bounds, Mesh &mesh,
+        Cmfd* cmfd, WeightWindows* weight_windows,
+        std::vector <Tally> &tallies, FluxArray &flux,
+        std::vector <Neutron> &split_neutrons);
+
+void geometryTrackNeutron(Neutron &neutron, Mesh &mesh, Geometry* geometry,
+        std::vector <Tally> &tallies, FluxArray &flux);
+
+void deltaTrackNeutron(Neutron &neutron, Boundaries &bounds, Mesh &mesh,
+        std::vector <Tally> &tallies, FluxArray &flux);
+
+void combineEstimates(std::vector <std::vector <double> > &samples,
+        double* mean, double* standard_error);
+bool entropyConverged(std::vector <double> &entropies, int window);
+void sortSitesByHistory(std::vector <double> &sites,
+        std::vector <int> &site_histories,
+        std::vector <std::pair <int, int> > &order,
+        std::vector <double> &sorted_sites);
 
 #endif
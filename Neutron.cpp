@@ -8,19 +8,34 @@
 #include "Neutron.h"
 
 /*
- @brief     constructor for Neutron class
- @param     position a vector containing the starting position of the neutron
- @param     theta the polar angle of the neutron's initial direction
- @param     phi the azimuthal angle of the neutron's initial direction
+ @brief     constructor for Neutron class, drawing random numbers from the
+            stream of the neutron's history in batch 0 with the default seed
  @param     neutron_num to be saved as the neutron's id number
 */
 Neutron::Neutron(int neutron_num) {
     _neutron_alive = true;
-    _neutron_direction.resize(3);
+    _weight = 1.0;
     _id = neutron_num;
+    _cell_path.num_levels = 0;
+    _cell_path.material = NULL;
     const int global_seed = 12;
-    _seed = _id + global_seed;
-    rand_r(&_seed);
+    _random = RandomStream(global_seed, 0, _id);
+}
+
+/*
+ @brief     constructor for Neutron class
+ @param     neutron_num to be saved as the neutron's id number, also the
+            history whose random number stream the neutron uses
+ @param     batch the batch the neutron is born in
+ @param     seed the global random number seed of the run
+*/
+Neutron::Neutron(int neutron_num, int batch, uint64_t seed) {
+    _neutron_alive = true;
+    _weight = 1.0;
+    _id = neutron_num;
+    _cell_path.num_levels = 0;
+    _cell_path.material = NULL;
+    _random = RandomStream(seed, batch, _id);
 }
 
 /*
@@ -44,6 +59,14 @@ int Neutron::getGroup() {
     return _neutron_group;
 }
 
+/*
+ @brief     returns the identification number of the neutron
+ @return    the neutron's id, its history number
+*/
+int Neutron::getId() {
+    return _id;
+}
+
 /*
  @brief     moves the neutron a given distance
  @param     distance the distance the neutron should be moved
@@ -62,6 +85,18 @@ void Neutron::reflect(int axis) {
     _neutron_direction[axis] *= -1;
 }
 
+/*
+ @brief     reflects the neutron's direction off a surface
+ @param     normal the unit normal of the surface where the neutron hits it
+*/
+void Neutron::reflect(double* normal) {
+    double dot = 0.0;
+    for (int i=0; i<3; ++i)
+        dot += _neutron_direction[i] * normal[i];
+    for (int i=0; i<3; ++i)
+        _neutron_direction[i] -= 2.0 * dot * normal[i];
+}
+
 /*
  @brief     changes the neutron's cell
  @param     axis the axis along which the cell should be changed
@@ -87,8 +122,10 @@ void Neutron::setPosition(int axis, double value) {
  @brief     sets the cell of the neutron
  @param     cell_number the cell to which the nuetron will be set
 */
-void Neutron::setCell(std::vector <int> &cell_number) {
-    _neutron_cell = cell_number;
+void Neutron::setCell(int* cell_number) {
+    for (int axis=0; axis<3; ++axis) {
+        _neutron_cell[axis] = cell_number[axis];
+    }
 }
 
 /*
@@ -100,12 +137,22 @@ void Neutron::kill() {
 
 /*
  @brief     returns the neutron's cell
- @return    the cell in which the neutron resides
+ @return    the cell in which the neutron resides, valid for the lifetime
+            of the neutron
 */
-std::vector <int> Neutron::getCell() {
+int* Neutron::getCell() {
     return _neutron_cell;
 }
 
+/*
+ @brief     returns the neutron's cells in a Geometry
+ @return    the cells holding the neutron at each level of universes, with
+            no levels if the neutron is not tracked through a Geometry
+*/
+CellPath* Neutron::getCellPath() {
+    return &_cell_path;
+}
+
 /*
  @brief     gets the position of the neutron along a certain axis
  @param     axis an int containing the axis along which the position will be
@@ -118,9 +165,9 @@ double Neutron::getPosition(int axis) {
 
 /*
  @brief     gets the position vector of the neutron
- @return    a vector containing the neutron's position
+ @return    the neutron's position, which changes as the neutron moves
 */
-std::vector <double> Neutron::getPositionVector() {
+double* Neutron::getPositionVector() {
     return _xyz;
 }
 
@@ -136,9 +183,9 @@ double Neutron::getDirection(int axis) {
 
 /*
  @brief     gets the direction vector of the neutron
- @return    a vector containing the neutron's direction
+ @return    the neutron's direction, which changes as the neutron scatters
 */
-std::vector <double> Neutron::getDirectionVector() {
+double* Neutron::getDirectionVector() {
     return _neutron_direction;
 }
 
@@ -147,12 +194,29 @@ std::vector <double> Neutron::getDirectionVector() {
  @param     coord a vector denoting the point to find the neutron's distance from
  @return    the neutron's distance from that point
 */
-double Neutron::getDistance(std::vector <double> &coord) {
+double Neutron::getDistance(double* coord) {
     return sqrt(pow(getPosition(0)-coord[0], 2.0)
             + pow(getPosition(1)-coord[1], 2.0)
             + pow(getPosition(2)-coord[2], 2.0));
 }
 
+/*
+ @brief     returns the statistical weight of the neutron
+ @return    the weight, 1 for a neutron that has only undergone analog
+            events
+*/
+double Neutron::getWeight() {
+    return _weight;
+}
+
+/*
+ @brief     set the statistical weight of the neutron
+ @param     weight the new weight
+*/
+void Neutron::setWeight(double weight) {
+    _weight = weight;
+}
+
 /*
  @brief     set the neutron's group
  @param     new_group the new energy group of the neutron
@@ -183,69 +247,54 @@ void Neutron::sampleDirection() {
  @brief     sets the neutron's position
  @param     position the position of the neutron
 */
-void Neutron::setPositionVector(std::vector <double> &position) {
-    _xyz = position;
+void Neutron::setPositionVector(double* position) {
+    for (int axis=0; axis<3; ++axis) {
+        _xyz[axis] = position[axis];
+    }
 }
 
 /*
- @brief     returns a pseudo-random number using the seed between 0 and 1
+ @brief     returns the next pseudo-random number from the neutron's stream
  @return    a psuedo-random number between 0 and 1
 */
 double Neutron::arand() {
-    double r = rand_r(&_seed);
-    return (double) r / (double) RAND_MAX;
+    return _random.arand();
 }
 
 /*
- @brief     returns a pseudo-random number using the seed
- @return    a psuedo-random number
+ @brief     fills an array with the next pseudo-random numbers from the
+            neutron's stream
+ @param     values the array to fill
+ @param     count the number of random numbers to draw
 */
-int Neutron::rand() {
-    return rand_r(&_seed);
+void Neutron::fillRandom(double* values, int count) {
+    _random.fill(values, count);
 }
 
 /*
- @brief     samples the neutron energy group after a scattering event
- @param     scattering_matrix the scattering cross section matrix
- @param     group the neutron energy group before scattering
- @return    the neutron group after scattering
+ @brief     returns a pseudo-random integer from the neutron's stream
+ @return    a psuedo-random number between 0 and RAND_MAX
 */
-int Neutron::sampleScatteredGroup(std::vector <double> &scattering_matrix,
-        int group) {
-
-    // get the total scattering cross-section from this group
-    int num_groups = scattering_matrix.size();
-    double scattering_total = 0;
-    for (int g=0; g < num_groups; ++g)
-        scattering_total += scattering_matrix[g];
-
-    // sample the outgoing scattered energy group
-    double r = arand() * scattering_total;
-    double scatter_sum = 0.0;
-    for (int g=0; g<num_groups; ++g) {
-        scatter_sum += scattering_matrix[g];
-        if (r<scatter_sum) {
-            return g;
-        }
-    }
+int Neutron::rand() {
+    return (int) (arand() * RAND_MAX);
+}
 
-    // return the last group if no group has been found yet 
-    return num_groups - 1;
+/*
+ @brief     gives a neutron split off this one random numbers of its own
+ @details   the split neutron's stream is moved to a position drawn from
+            this neutron's stream. Positions take 64 bits, so the numbers
+            the two neutrons go on to draw will in practice never overlap.
+ @param     split a copy of this neutron
+*/
+void Neutron::branchRandomStream(Neutron &split) {
+    split._random.setPosition((uint64_t) ldexp(_random.arand(), 64));
 }
 
 /*
- @brief     samples an initial neutron energy group after fission
- @param     chi the neutron emission spectrum from fission
- @return    the group number of the emitted neutron
+ @brief     returns the current state of the neutron's random number stream
+            so that it can be continued elsewhere
+ @return    a copy of the random number stream
 */
-int Neutron::sampleNeutronEnergyGroup(std::vector <double> chi) {
-    double r = arand();
-    double chi_sum = 0.0;
-    for (int g=0; g<chi.size(); ++g) {
-        chi_sum += chi[g];
-        if (r<chi_sum) {
-            return g;
-        }
-    }
-    return chi.size() - 1;
+RandomStream Neutron::getRandomStream() {
+    return _random;
 }
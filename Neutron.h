@@ -16,37 +16,45 @@
 #include <stdlib.h>
 
 #include "Surface.h"
+#include "Random_stream.h"
+#include "Cell_path.h"
 
 class Neutron {
 public:
     Neutron(int neutron_num);
+    Neutron(int neutron_num, int batch, uint64_t seed);
     virtual ~Neutron();
 
     void changeCell(int axis, min_max side);
     void kill();
     void move(double distance);
     void reflect(int axis);
-    void setCell(std::vector <int> &cell_number);
+    void reflect(double* normal);
+    void setCell(int* cell_number);
     void setGroup(int new_group);
     void setPosition(int axis, double value);
-    void setPositionVector(std::vector <double> &position);
+    void setPositionVector(double* position);
+    void setWeight(double weight);
     void sampleDirection();
+    void fillRandom(double* values, int count);
+    void branchRandomStream(Neutron &split);
     double arand();
     double getDirection(int axis);
-    double getDistance(std::vector <double> &coord);
+    double getDistance(double* coord);
     double getPosition(int axis);
+    double getWeight();
     double x();
     double y();
     double z();
     bool alive();
     int getGroup();
+    int getId();
     int rand();
-    int sampleNeutronEnergyGroup(std::vector <double> chi);
-    int sampleScatteredGroup(std::vector <double> &scattering_matrix,
-            int group);
-    std::vector <int> getCell();
-    std::vector <double> getPositionVector();
-    std::vector <double> getDirectionVector();
+    RandomStream getRandomStream();
+    int* getCell();
+    CellPath* getCellPath();
+    double* getPositionVector();
+    double* getDirectionVector();
 
 private:
     
@@ -56,20 +64,27 @@ private:
     /** energy group of the neutron */
     int _neutron_group;
 
+    /** statistical weight of the neutron, the number of real neutrons it
+        stands for */
+    double _weight;
+
     /** position of the neutron */
-    std::vector <double> _xyz;
+    double _xyz[3];
 
     /** direction of travel of the neutron */
-    std::vector <double> _neutron_direction;
+    double _neutron_direction[3];
 
     /** cell of the neutron */
-    std::vector <int> _neutron_cell;
+    int _neutron_cell[3];
+
+    /** cells of the neutron in a Geometry, if it is tracked through one */
+    CellPath _cell_path;
 
     /** identification number */
     int _id;
 
-    /** to be used in calling rand_r() */
-    unsigned int _seed;
+    /** stream of random numbers used by this neutron */
+    RandomStream _random;
 };
 
 #endif
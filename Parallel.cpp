@@ -0,0 +1,240 @@
+/*
+ @file      Parallel.cpp
+ @brief     functions for spreading batches over MPI processes
+ @details   each rank runs a contiguous share of a batch's histories.
+            Tallies and flux are summed over all ranks at the end of the
+            batch. The fission bank stays distributed: the sites of each rank
+            are a contiguous piece of the global bank, and sites are only
+            ever sent between ranks whose pieces overlap, which for a
+            balanced bank are neighbouring ranks. Without USE_MPI these
+            functions treat the run as a single rank.
+ @author    Luke Eure
+ @date      March 14 2016
+*/
+
+#include "Parallel.h"
+
+#ifdef USE_MPI
+/*
+ @brief     finalizes MPI, registered with atexit() by initializeParallel()
+*/
+static void finalizeParallel() {
+    MPI_Finalize();
+}
+#endif
+
+/*
+ @brief     initializes MPI if it has not been already, finalizing it when
+            the program exits
+*/
+void initializeParallel() {
+#ifdef USE_MPI
+    int initialized;
+    MPI_Initialized(&initialized);
+    if (!initialized) {
+        MPI_Init(NULL, NULL);
+        atexit(finalizeParallel);
+    }
+#endif
+}
+
+/*
+ @brief     returns the rank of this process
+ @return    the rank, 0 without MPI
+*/
+int getRank() {
+    int rank = 0;
+#ifdef USE_MPI
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#endif
+    return rank;
+}
+
+/*
+ @brief     returns the number of processes
+ @return    the number of ranks, 1 without MPI
+*/
+int getNumRanks() {
+    int num_ranks = 1;
+#ifdef USE_MPI
+    MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+#endif
+    return num_ranks;
+}
+
+/*
+ @brief     finds the histories of a batch run by this rank
+ @param     n_histories the number of histories in the batch
+ @param     first_history set to the first history of this rank
+ @param     last_history set to one past the last history of this rank
+*/
+void getRankHistories(int n_histories, int* first_history,
+        int* last_history) {
+    int rank = getRank();
+    int num_ranks = getNumRanks();
+    *first_history = (long) n_histories * rank / num_ranks;
+    *last_history = (long) n_histories * (rank + 1) / num_ranks;
+}
+
+/*
+ @brief     sums the current batch of a tally over all ranks, leaving the
+            totals on every rank
+ @param     tally the tally of this rank
+*/
+void reduceTally(Tally &tally) {
+#ifdef USE_MPI
+    // sum the values in place, in pieces small enough for an int count
+    double* values = tally.getBatchValues();
+    long size = tally.getSize();
+    for (long first=0; first<size; first+=MAX_REDUCE_COUNT) {
+        int count = std::min((long) MAX_REDUCE_COUNT, size - first);
+        MPI_Allreduce(MPI_IN_PLACE, values + first, count, MPI_DOUBLE,
+                MPI_SUM, MPI_COMM_WORLD);
+    }
+#endif
+}
+
+/*
+ @brief     sums the flux of the current batch over all ranks, leaving the
+            total on every rank
+ @param     mesh a Mesh object containing this rank's flux
+*/
+void reduceFlux(Mesh &mesh) {
+#ifdef USE_MPI
+    FluxView flux = mesh.getBatchFlux();
+
+    // sum the flux in place, in pieces small enough for an int count
+    double* values = flux.getValues();
+    long size = flux.getSize();
+    for (long first=0; first<size; first+=MAX_REDUCE_COUNT) {
+        int count = std::min((long) MAX_REDUCE_COUNT, size - first);
+        MPI_Allreduce(MPI_IN_PLACE, values + first, count, MPI_DOUBLE,
+                MPI_SUM, MPI_COMM_WORLD);
+    }
+#endif
+}
+
+/*
+ @brief     sums an array of values over all ranks, leaving the totals on
+            every rank
+ @param     values the values of this rank
+*/
+void reduceValues(std::vector <double> &values) {
+#ifdef USE_MPI
+    MPI_Allreduce(MPI_IN_PLACE, &values[0], values.size(), MPI_DOUBLE,
+            MPI_SUM, MPI_COMM_WORLD);
+#endif
+}
+
+/*
+ @brief     sums a weight over the ranks before this one and over all ranks
+ @param     weight the weight held by this rank
+ @param     total_weight set to the sum of the weights of all ranks
+ @return    the sum of the weights of the ranks before this one
+*/
+double getWeightOffset(double weight, double* total_weight) {
+    double offset = 0.0;
+    *total_weight = weight;
+#ifdef USE_MPI
+    MPI_Exscan(&weight, &offset, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    if (getRank() == 0)
+        offset = 0.0;
+    MPI_Allreduce(&weight, total_weight, 1, MPI_DOUBLE, MPI_SUM,
+            MPI_COMM_WORLD);
+#endif
+    return offset;
+}
+
+/*
+ @brief     returns the number of sites in the global bank
+ @param     sites this rank's piece of the bank
+ @param     values_per_site the number of values stored for each site
+ @return    the total number of sites on all ranks
+*/
+long getGlobalSiteCount(std::vector <double> &sites, int values_per_site) {
+    long num_sites = sites.size() / values_per_site;
+#ifdef USE_MPI
+    MPI_Allreduce(MPI_IN_PLACE, &num_sites, 1, MPI_LONG, MPI_SUM,
+            MPI_COMM_WORLD);
+#endif
+    return num_sites;
+}
+
+/*
+ @brief     redistributes the global bank so every rank holds a contiguous
+            piece of nearly the same size
+ @param     sites this rank's piece of the bank, replaced by its new piece
+ @param     values_per_site the number of values stored for each site
+ @param     received scratch buffer for the new piece, see
+            redistributeSites()
+*/
+void balanceSites(std::vector <double> &sites, int values_per_site,
+        std::vector <double> &received) {
+    long num_sites = getGlobalSiteCount(sites, values_per_site);
+    int rank = getRank();
+    int num_ranks = getNumRanks();
+    redistributeSites(sites, values_per_site, num_sites * rank / num_ranks,
+            num_sites * (rank + 1) / num_ranks, received);
+}
+
+/*
+ @brief     gathers a range of the global bank onto this rank
+ @details   the global bank is the pieces held by each rank placed end to
+            end in rank order. A prefix sum gives the offset of each rank's
+            piece, and each rank sends the parts of its piece that overlap
+            another rank's requested range straight to that rank. The
+            requested ranges must be in rank order and not overlap.
+ @param     sites this rank's piece of the bank, replaced by the sites in
+            [first_site, last_site) of the global bank
+ @param     values_per_site the number of values stored for each site
+ @param     first_site the first global site wanted by this rank
+ @param     last_site one past the last global site wanted by this rank
+ @param     received scratch buffer the sites are gathered into, then
+            swapped with sites; kept by the caller so it does not allocate
+            once it has grown
+*/
+void redistributeSites(std::vector <double> &sites, int values_per_site,
+        long first_site, long last_site, std::vector <double> &received) {
+#ifdef USE_MPI
+    int num_ranks = getNumRanks();
+
+    // offset of this rank's piece in the global bank
+    long num_sites = sites.size() / values_per_site;
+    long offset = 0;
+    MPI_Exscan(&num_sites, &offset, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (getRank() == 0)
+        offset = 0;
+
+    // the piece held and the range wanted by every rank
+    long mine[4] = {offset, offset + num_sites, first_site, last_site};
+    std::vector <long> all(4 * num_ranks);
+    MPI_Allgather(mine, 4, MPI_LONG, &all[0], 4, MPI_LONG, MPI_COMM_WORLD);
+
+    received.resize((last_site - first_site) * values_per_site);
+    std::vector <MPI_Request> requests;
+    for (int r=0; r<num_ranks; ++r) {
+
+        // receive the overlap of rank r's piece with the range wanted here
+        long start = std::max(all[4*r], first_site);
+        long end = std::min(all[4*r+1], last_site);
+        if (start < end) {
+            requests.push_back(MPI_Request());
+            MPI_Irecv(&received[(start - first_site) * values_per_site],
+                    (end - start) * values_per_site, MPI_DOUBLE, r, 0,
+                    MPI_COMM_WORLD, &requests.back());
+        }
+
+        // send the overlap of this rank's piece with the range wanted by r
+        start = std::max(offset, all[4*r+2]);
+        end = std::min(offset + num_sites, all[4*r+3]);
+        if (start < end) {
+            requests.push_back(MPI_Request());
+            MPI_Isend(&sites[(start - offset) * values_per_site],
+                    (end - start) * values_per_site, MPI_DOUBLE, r, 0,
+                    MPI_COMM_WORLD, &requests.back());
+        }
+    }
+    MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+    sites.swap(received);
+#endif
+}
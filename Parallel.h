@@ -0,0 +1,39 @@
+/*
+ @file      Parallel.h
+ @brief     functions for spreading batches over MPI processes
+ @author    Luke Eure
+ @date      March 14 2016
+*/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+#include "Tally.h"
+#include "Mesh.h"
+
+/** most values summed by a single MPI call */
+const int MAX_REDUCE_COUNT = 1 << 28;
+
+void initializeParallel();
+int getRank();
+int getNumRanks();
+void getRankHistories(int n_histories, int* first_history, int* last_history);
+void reduceTally(Tally &tally);
+void reduceFlux(Mesh &mesh);
+void reduceValues(std::vector <double> &values);
+double getWeightOffset(double weight, double* total_weight);
+long getGlobalSiteCount(std::vector <double> &sites, int values_per_site);
+void balanceSites(std::vector <double> &sites, int values_per_site,
+        std::vector <double> &received);
+void redistributeSites(std::vector <double> &sites, int values_per_site,
+        long first_site, long last_site, std::vector <double> &received);
+
+#endif
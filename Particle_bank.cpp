@@ -0,0 +1,409 @@
+/*
+ @file      Particle_bank.cpp
+ @brief     contains functions for the ParticleBank class
+ @author    Luke Eure
+ @date      March 2 2016
+*/
+
+#include "Particle_bank.h"
+#include "Monte_carlo.h"
+
+/*
+ @brief     constructor for ParticleBank class
+ @param     capacity the largest number of neutrons the bank will hold
+*/
+ParticleBank::ParticleBank(int capacity) {
+    _size = 0;
+    for (int axis=0; axis<3; ++axis) {
+        _xyz[axis].resize(capacity);
+        _direction[axis].resize(capacity);
+        _start[axis].resize(capacity);
+        _cell[axis].resize(capacity);
+    }
+    _group.resize(capacity);
+    _weight.resize(capacity);
+    _alive.resize(capacity);
+    _collides.resize(capacity);
+    _crossing_axis.resize(capacity);
+    _distance.resize(capacity);
+    _boundary_distance.resize(capacity);
+    _history.resize(capacity);
+    _random.resize(capacity);
+}
+
+/*
+ @brief     deconstructor
+*/
+ParticleBank::~ParticleBank() {}
+
+/*
+ @brief     adds a source neutron to the bank
+ @param     neutron a neutron with its position, direction and group set
+ @param     history the history number of the neutron
+*/
+void ParticleBank::add(Neutron &neutron, int history) {
+    int i = _size;
+    int* cell = neutron.getCell();
+    for (int axis=0; axis<3; ++axis) {
+        _xyz[axis][i] = neutron.getPosition(axis);
+        _start[axis][i] = neutron.getPosition(axis);
+        _direction[axis][i] = neutron.getDirection(axis);
+        _cell[axis][i] = cell[axis];
+    }
+    _group[i] = neutron.getGroup();
+    _weight[i] = neutron.getWeight();
+    _alive[i] = 1;
+    _collides[i] = 0;
+    _distance[i] = 0.0;
+    _history[i] = history;
+    _random[i] = neutron.getRandomStream();
+    _size++;
+}
+
+/*
+ @brief     returns the number of live neutrons in the bank
+ @return    the number of live neutrons
+*/
+int ParticleBank::size() {
+    return _size;
+}
+
+/*
+ @brief     samples a distance to collision for each neutron that has just
+            been born or scattered
+ @param     mesh a Mesh object containing information about the mesh
+*/
+void ParticleBank::sampleDistances(Mesh &mesh) {
+    for (int i=0; i<_size; ++i) {
+        if (_distance[i] == 0.0) {
+            Material* cell_mat = getMaterial(mesh, i);
+            _distance[i] = -log(arand(i)) / cell_mat->getSigmaT(_group[i]);
+        }
+    }
+}
+
+/*
+ @brief     finds the distance to, and axis of, the nearest cell surface
+            along each neutron's direction of travel
+ @details   a neutron sitting just past a surface from roundoff gets a
+            distance of zero rather than a negative one
+ @param     mesh a Mesh object containing information about the mesh
+*/
+void ParticleBank::findBoundaryDistances(Mesh &mesh) {
+    for (int i=0; i<_size; ++i) {
+        _boundary_distance[i] = INFINITY;
+        _crossing_axis[i] = 0;
+    }
+    for (int axis=0; axis<3; ++axis) {
+        double* planes = mesh.getPlanes(axis);
+        double* xyz = &_xyz[axis][0];
+        double* direction = &_direction[axis][0];
+        int* cell = &_cell[axis][0];
+        double* boundary_distance = &_boundary_distance[0];
+        int* crossing_axis = &_crossing_axis[0];
+
+        #pragma omp simd
+        for (int i=0; i<_size; ++i) {
+
+            // the surface ahead is the cell max if moving up the axis
+            double edge = planes[cell[i] + (direction[i] > 0.0)];
+            double r = (edge - xyz[i]) / direction[i];
+            bool closer = r < boundary_distance[i];
+            boundary_distance[i] = closer ? r : boundary_distance[i];
+            crossing_axis[i] = closer ? axis : crossing_axis[i];
+        }
+    }
+    double* boundary_distance = &_boundary_distance[0];
+    #pragma omp simd
+    for (int i=0; i<_size; ++i)
+        boundary_distance[i] = boundary_distance[i] > 0.0
+            ? boundary_distance[i] : 0.0;
+}
+
+/*
+ @brief     moves each neutron to its collision site or the nearest cell
+            surface, whichever is closer, and adds the track to the flux
+            and tallies
+ @param     mesh a Mesh object containing information about the mesh
+ @param     cmfd the coarse mesh to score in the last of the tallies, or
+            NULL for none
+ @param     tallies a vector of tallies to score track lengths in
+ @param     flux the flux array to add track lengths to
+*/
+void ParticleBank::moveAndTally(Mesh &mesh, Cmfd* cmfd,
+        std::vector <Tally> &tallies, FluxArray &flux) {
+    double* distance = &_distance[0];
+    double* boundary_distance = &_boundary_distance[0];
+    int* collides = &_collides[0];
+
+    // track length to travel
+    #pragma omp simd
+    for (int i=0; i<_size; ++i) {
+        collides[i] = distance[i] <= boundary_distance[i];
+        boundary_distance[i] = collides[i] ? distance[i]
+            : boundary_distance[i];
+        distance[i] -= boundary_distance[i];
+    }
+
+    // add distances to the cell fluxes and tallies
+    for (int i=0; i<_size; ++i) {
+        int cell[3] = {_cell[0][i], _cell[1][i], _cell[2][i]};
+        double position[3] = {_xyz[0][i], _xyz[1][i], _xyz[2][i]};
+        double direction[3] = {_direction[0][i], _direction[1][i],
+            _direction[2][i]};
+        mesh.fluxAddTrack(cell, position, direction, boundary_distance[i],
+                _weight[i], _group[i], flux);
+        Material* cell_mat = getMaterial(mesh, i);
+        double track = boundary_distance[i] * _weight[i];
+        scoreTallies(tallies, cell, _group[i], cell_mat, track);
+        tallies[EVENT_TALLY].add(TRACK_LENGTH_K, track * cell_mat->getNu()
+                * cell_mat->getSigmaF(_group[i]));
+        if (cmfd != NULL)
+            cmfd->score(tallies.back(), cell, _group[i], cell_mat, track);
+    }
+
+    // move neutrons
+    for (int axis=0; axis<3; ++axis) {
+        double* xyz = &_xyz[axis][0];
+        double* direction = &_direction[axis][0];
+
+        #pragma omp simd
+        for (int i=0; i<_size; ++i) {
+            xyz[i] += direction[i] * boundary_distance[i];
+        }
+    }
+}
+
+/*
+ @brief     moves each neutron that reached a cell surface into the next
+            cell, applying the boundary conditions at the edge of the geometry
+ @param     bounds a Boundaries object containing the limits of the
+            bounding box
+ @param     mesh a Mesh object containing information about the mesh
+ @param     cmfd the coarse mesh to count crossings in the last of the
+            tallies, or NULL for none
+ @param     tallies a vector of tallies in which to count leaks and
+            crossings
+*/
+void ParticleBank::crossSurfaces(Boundaries &bounds, Mesh &mesh, Cmfd* cmfd,
+        std::vector <Tally> &tallies) {
+    for (int i=0; i<_size; ++i) {
+        if (_collides[i])
+            continue;
+
+        int axis = _crossing_axis[i];
+        int side = _direction[axis][i] > 0.0 ? MAX : MIN;
+        int new_cell = _cell[axis][i] + (side == MAX ? 1 : -1);
+        int cell[3] = {_cell[0][i], _cell[1][i], _cell[2][i]};
+        Material* old_mat = getMaterial(mesh, i);
+        scoreCrossingTallies(tallies, cell, axis, side, _direction[axis][i],
+                _group[i], old_mat, _weight[i]);
+        if (cmfd != NULL) {
+            cmfd->scoreCrossing(tallies.back(), cell, axis, (min_max) side,
+                    _group[i], _weight[i]);
+        }
+
+        // place neutron on the surface to eliminate roundoff error
+        _xyz[axis][i] = mesh.getPlane(axis, _cell[axis][i] + side);
+
+        // move into the neighbouring cell if still in the geometry, keeping
+        // the number of mean free paths left to travel
+        if (new_cell >= 0 && new_cell < mesh.getAxisSize(axis)) {
+            _cell[axis][i] = new_cell;
+            Material* new_mat = getMaterial(mesh, i);
+            if (new_mat != old_mat) {
+                _distance[i] *= old_mat->getSigmaT(_group[i])
+                    / new_mat->getSigmaT(_group[i]);
+            }
+        }
+
+        // if the neutron is reflected, crossing back into its cell
+        else if (bounds.getSurfaceType(axis, side) == REFLECTIVE) {
+            _direction[axis][i] *= -1;
+            scoreCrossingTallies(tallies, cell, axis, side,
+                    _direction[axis][i], _group[i], old_mat, _weight[i]);
+        }
+
+        // if the neutron escapes
+        else {
+            _alive[i] = 0;
+            tallies[EVENT_TALLY].add(LEAKS, _weight[i]);
+        }
+    }
+}
+
+/*
+ @brief     samples the interaction of each neutron that reached its
+            collision site
+ @details   with survival biasing a neutron is never absorbed: it scores the
+            absorbed part of its weight, banks the fission neutrons expected
+            from the collision at the collision site and scatters, then
+            plays Russian roulette if its weight is below the cutoff
+ @param     mesh a Mesh object containing information about the mesh
+ @param     tallies a vector of tallies in which to count absorptions
+            and fissions
+ @param     fission_sites a buffer of new fission sites, SITE_SIZE values
+            per site
+ @param     site_histories the history number of each site in fission_sites
+ @param     survival_biasing true for implicit capture, false for analog
+            absorption
+ @param     weight_cutoff the weight below which survival biased neutrons
+            play Russian roulette
+ @param     survival_weight the weight of the neutrons that survive roulette
+*/
+void ParticleBank::collide(Mesh &mesh, std::vector <Tally> &tallies,
+        std::vector <double> &fission_sites,
+        std::vector <int> &site_histories, bool survival_biasing,
+        double weight_cutoff, double survival_weight) {
+    for (int i=0; i<_size; ++i) {
+        if (!_collides[i] || !_alive[i])
+            continue;
+
+        Material* cell_mat = getMaterial(mesh, i);
+        int group = _group[i];
+        double weight = _weight[i];
+        double nu_sigma_f = cell_mat->getNu() * cell_mat->getSigmaF(group);
+        tallies[EVENT_TALLY].add(COLLISION_K,
+                weight * nu_sigma_f / cell_mat->getSigmaT(group));
+
+        // score the absorbed part of a survival biased neutron's weight and
+        // bank the fission neutrons expected from it
+        int num_fission = 0;
+        bool scatters;
+        if (survival_biasing) {
+            double absorbed = weight * cell_mat->getSigmaA(group)
+                / cell_mat->getSigmaT(group);
+            double production = weight * nu_sigma_f
+                / cell_mat->getSigmaT(group);
+            tallies[EVENT_TALLY].add(ABSORPTIONS, absorbed);
+            tallies[EVENT_TALLY].add(ABSORPTION_K, production);
+            if (production > 0.0)
+                num_fission = (int) (production + arand(i));
+            _weight[i] = weight - absorbed;
+            scatters = true;
+        }
+        else {
+            scatters = arand(i) >= cell_mat->getSigmaA(group)
+                / cell_mat->getSigmaT(group);
+        }
+
+        // scattering event
+        if (scatters) {
+
+            // sample scattered direction
+            double phi = 2 * M_PI * arand(i);
+            double mu = 2 * arand(i) - 1.0;
+            _direction[0][i] = sqrt(1 - mu*mu) * cos(phi);
+            _direction[1][i] = sqrt(1 - mu*mu) * sin(phi);
+            _direction[2][i] = mu;
+
+            // sample new energy group
+            _group[i] = cell_mat->sampleScatteredGroup(group, arand(i));
+
+            // roulette survival biased neutrons of low weight
+            if (survival_biasing && _weight[i] < weight_cutoff) {
+                if (arand(i) * survival_weight < _weight[i])
+                    _weight[i] = survival_weight;
+                else
+                    _alive[i] = 0;
+            }
+        }
+
+        // absorption event
+        else {
+            tallies[EVENT_TALLY].add(ABSORPTIONS, weight);
+            tallies[EVENT_TALLY].add(ABSORPTION_K,
+                    weight * nu_sigma_f / cell_mat->getSigmaA(group));
+
+            // fission event
+            if (arand(i) < cell_mat->getSigmaF(group)
+                    / cell_mat->getSigmaA(group)) {
+                double nu = cell_mat->getNu();
+                num_fission = (int) nu + (int) (arand(i) < nu - (int) nu);
+            }
+
+            // end neutron history
+            _alive[i] = 0;
+        }
+
+        // bank the fission neutrons at the collision site
+        for (int n=0; n<num_fission; ++n) {
+            for (int axis=0; axis<3; ++axis)
+                fission_sites.push_back(_xyz[axis][i]);
+            fission_sites.push_back(1.0);
+            site_histories.push_back(_history[i]);
+            tallies[EVENT_TALLY].add(FISSIONS, 1.0);
+        }
+    }
+}
+
+/*
+ @brief     tallies the crow distance of each dead neutron and removes it,
+            moving the last live neutron into its place
+ @param     tallies a vector of tallies in which to record crow distances
+*/
+void ParticleBank::removeDead(std::vector <Tally> &tallies) {
+    int i = 0;
+    while (i < _size) {
+        if (_alive[i]) {
+            ++i;
+            continue;
+        }
+
+        // tally crow distance
+        double crow_distance = 0.0;
+        for (int axis=0; axis<3; ++axis) {
+            crow_distance += (_xyz[axis][i] - _start[axis][i])
+                * (_xyz[axis][i] - _start[axis][i]);
+        }
+        tallies[EVENT_TALLY].add(CROWS, sqrt(crow_distance));
+        tallies[EVENT_TALLY].add(NUM_CROWS, 1.0);
+
+        _size--;
+        copyParticle(_size, i);
+    }
+}
+
+/*
+ @brief     returns the next pseudo-random number from a neutron's stream
+ @param     i the index of the neutron in the bank
+ @return    a psuedo-random number between 0 and 1
+*/
+double ParticleBank::arand(int i) {
+    return _random[i].arand();
+}
+
+/*
+ @brief     returns the material of the cell containing a neutron
+ @param     mesh a Mesh object containing information about the mesh
+ @param     i the index of the neutron in the bank
+ @return    the material of the neutron's cell
+*/
+Material* ParticleBank::getMaterial(Mesh &mesh, int i) {
+    for (int axis=0; axis<3; ++axis)
+        _lookup_cell[axis] = _cell[axis][i];
+    return mesh.getMaterial(_lookup_cell);
+}
+
+/*
+ @brief     copies the state of one neutron in the bank over another
+ @param     from the index of the neutron to copy
+ @param     to the index to copy the neutron to
+*/
+void ParticleBank::copyParticle(int from, int to) {
+    for (int axis=0; axis<3; ++axis) {
+        _xyz[axis][to] = _xyz[axis][from];
+        _direction[axis][to] = _direction[axis][from];
+        _start[axis][to] = _start[axis][from];
+        _cell[axis][to] = _cell[axis][from];
+    }
+    _group[to] = _group[from];
+    _weight[to] = _weight[from];
+    _alive[to] = _alive[from];
+    _collides[to] = _collides[from];
+    _crossing_axis[to] = _crossing_axis[from];
+    _distance[to] = _distance[from];
+    _boundary_distance[to] = _boundary_distance[from];
+    _history[to] = _history[from];
+    _random[to] = _random[from];
+}
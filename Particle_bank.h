@@ -0,0 +1,101 @@
+/*
+ @file      Particle_bank.h
+ @brief     contains the ParticleBank class
+ @author    Luke Eure
+ @date      March 2 2016
+*/
+
+#ifndef PARTICLE_BANK_H
+#define PARTICLE_BANK_H
+
+#include <vector>
+#include <math.h>
+#include <stdlib.h>
+
+#include "Tally.h"
+#include "Mesh.h"
+#include "Neutron.h"
+#include "Boundaries.h"
+#include "Random_stream.h"
+#include "Cmfd.h"
+
+/*
+ @brief     a batch of neutrons stored as a structure of arrays
+ @details   each stage of the event-based transport loop is a method that
+            runs over all of the live neutrons in the bank, keeping the
+            per-neutron work short and free of calls so it can be vectorized.
+            Dead neutrons are removed between steps so the live neutrons are
+            always stored in [0, size()).
+*/
+class ParticleBank {
+
+public:
+    ParticleBank(int capacity);
+    virtual ~ParticleBank();
+
+    void add(Neutron &neutron, int history);
+    int size();
+    void sampleDistances(Mesh &mesh);
+    void findBoundaryDistances(Mesh &mesh);
+    void moveAndTally(Mesh &mesh, Cmfd* cmfd, std::vector <Tally> &tallies,
+            FluxArray &flux);
+    void crossSurfaces(Boundaries &bounds, Mesh &mesh, Cmfd* cmfd,
+            std::vector <Tally> &tallies);
+    void collide(Mesh &mesh, std::vector <Tally> &tallies,
+            std::vector <double> &fission_sites,
+            std::vector <int> &site_histories, bool survival_biasing,
+            double weight_cutoff, double survival_weight);
+    void removeDead(std::vector <Tally> &tallies);
+
+private:
+    double arand(int i);
+    Material* getMaterial(Mesh &mesh, int i);
+    void copyParticle(int from, int to);
+
+    /** number of live neutrons in the bank */
+    int _size;
+
+    /** position of each neutron along each axis */
+    std::vector <double> _xyz[3];
+
+    /** direction of travel of each neutron along each axis */
+    std::vector <double> _direction[3];
+
+    /** birth position of each neutron along each axis */
+    std::vector <double> _start[3];
+
+    /** cell of each neutron along each axis */
+    std::vector <int> _cell[3];
+
+    /** energy group of each neutron */
+    std::vector <int> _group;
+
+    /** statistical weight of each neutron */
+    std::vector <double> _weight;
+
+    /** 1 if the neutron is alive, 0 once it has leaked or been absorbed */
+    std::vector <int> _alive;
+
+    /** 1 if the neutron reaches its collision site on this step */
+    std::vector <int> _collides;
+
+    /** axis of the cell surface the neutron will cross next */
+    std::vector <int> _crossing_axis;
+
+    /** remaining distance to the next collision, 0 if one must be sampled */
+    std::vector <double> _distance;
+
+    /** distance to the nearest cell surface along the direction of travel */
+    std::vector <double> _boundary_distance;
+
+    /** history number of each neutron */
+    std::vector <int> _history;
+
+    /** random number stream of each neutron */
+    std::vector <RandomStream> _random;
+
+    /** scratch cell for mesh lookups */
+    int _lookup_cell[3];
+};
+
+#endif
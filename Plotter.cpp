@@ -1,28 +1,96 @@
 /*
  @file      Plotter.cpp
- @brief     plotting function
+ @brief     flux output function
  @author    Luke Eure
  @date      January 28 2016
 */
 
 #include "Plotter.h"
 
-void printFluxToFile(std::vector <std::vector <std::vector <std::vector <double> > > >
-       &_flux) {
-    
-    std::ofstream out("flux_plot.txt");
-    
-    for (int i=0; i<_flux.size(); ++i) {
-        out << "\n";
-        for (int j=0; j<_flux[0].size(); ++j) {
-            out << "\n";
-            for (int k=0; k<_flux[0][0].size(); ++k) {
-                out << "\n";
-                for (int l=0; l<_flux[0][0][0].size(); ++l) {
-                    out << _flux[i][j][k][l] << " ";
-                }
+/*
+ @brief     writes the mean flux and its standard deviation over the batches
+            ended to a binary file, read by Flux_parser.py
+ @details   the file is a header followed by the mean and then the
+            standard deviation of the mean of every flux value, each an
+            array of doubles in the layout of the mesh flux. The first
+            FLUX_HEADER_SIZE bytes of the header hold, in native byte order
+            and without padding:
+            the 8 byte magic "MGMCFLUX", then as 32 bit integers the format
+            version, the header size, the number of groups, the number of
+            cells along x, y and z, the layout (0 for GROUP_OUTER, 1 for
+            GROUP_INNER) and the number of batches, then as doubles the
+            minimum of the flux grid and the average cell width along each axis,
+            with the rest zero. The grid planes along x, y and z follow as
+            doubles, and the header is padded with zeros to a multiple of
+            FLUX_HEADER_SIZE bytes. With MPI only the first process writes.
+ @param     mesh a Mesh object containing the flux
+ @param     file_name the name of the file to write
+*/
+void writeFluxToFile(Mesh &mesh, std::string file_name) {
+    if (getRank() != 0)
+        return;
+
+    Grid &grid = mesh.getFluxGrid();
+    FluxView flux = mesh.getFlux();
+    FluxView flux_squared = mesh.getFluxSquared();
+    long size = flux.getSize();
+    int num_batches = mesh.getNumFluxBatches();
+
+    // the header and grid planes
+    long num_planes = 3;
+    for (int axis=0; axis<3; ++axis)
+        num_planes += grid.getAxisSize(axis);
+    long header_size = FLUX_HEADER_SIZE + num_planes * sizeof(double);
+    header_size = (header_size + FLUX_HEADER_SIZE - 1) / FLUX_HEADER_SIZE
+        * FLUX_HEADER_SIZE;
+    std::vector <double> header_buffer(header_size / sizeof(double), 0.0);
+    char* header = (char*) &header_buffer[0];
+    int32_t integers[] = {FLUX_FILE_VERSION, (int32_t) header_size,
+        flux.getNumGroups(), flux.getAxisSize(0), flux.getAxisSize(1),
+        flux.getAxisSize(2), flux.getLayout() == GROUP_INNER, num_batches};
+    double geometry[6];
+    for (int axis=0; axis<3; ++axis) {
+        geometry[axis] = grid.getBoundaryMin(axis);
+        geometry[3 + axis] = (grid.getBoundaryMax(axis)
+                - grid.getBoundaryMin(axis)) / grid.getAxisSize(axis);
+    }
+    memcpy(header, FLUX_FILE_MAGIC, sizeof(FLUX_FILE_MAGIC));
+    memcpy(header + sizeof(FLUX_FILE_MAGIC), integers, sizeof(integers));
+    memcpy(header + sizeof(FLUX_FILE_MAGIC) + sizeof(integers), geometry,
+            sizeof(geometry));
+    double* planes = &header_buffer[FLUX_HEADER_SIZE / sizeof(double)];
+    for (int axis=0; axis<3; ++axis) {
+        memcpy(planes, grid.getPlanes(axis),
+                (grid.getAxisSize(axis) + 1) * sizeof(double));
+        planes += grid.getAxisSize(axis) + 1;
+    }
+
+    FILE* out = fopen(file_name.c_str(), "wb");
+    if (out == NULL) {
+        std::cout << "Could not open " << file_name << " for writing"
+            << std::endl;
+        return;
+    }
+    fwrite(&header_buffer[0], sizeof(double), header_buffer.size(), out);
+
+    // the mean and then the standard deviation of the mean of each value,
+    // computed a block at a time so large meshes need no second copy
+    double* sum = flux.getValues();
+    double* squared = flux_squared.getValues();
+    std::vector <double> block(std::min(size, (long) FLUX_WRITE_BLOCK));
+    for (int array=0; array<2; ++array) {
+        for (long first=0; first<size; first+=block.size()) {
+            long count = std::min((long) block.size(), size - first);
+            for (long i=0; i<count; ++i) {
+                double mean = num_batches > 0
+                    ? sum[first + i] / num_batches : 0.0;
+                double variance = num_batches > 1
+                    ? squared[first + i] / num_batches - mean * mean : 0.0;
+                block[i] = array == 0 ? mean : (variance > 0.0
+                        ? sqrt(variance / (num_batches - 1)) : 0.0);
             }
+            fwrite(&block[0], sizeof(double), count, out);
         }
     }
-    out.close();
+    fclose(out);
 }
@@ -8,11 +8,32 @@
 #ifndef PLOTTER_H
 #define PLOTTER_H
 
-#include <fstream>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
 #include <vector>
+#include <algorithm>
+#include <string>
+
+#include "Mesh.h"
+#include "Parallel.h"
+
+/** identifies a binary flux file */
+const char FLUX_FILE_MAGIC[8] = {'M', 'G', 'M', 'C', 'F', 'L', 'U', 'X'};
+
+/** version of the binary flux file format */
+const int32_t FLUX_FILE_VERSION = 2;
+
+/** size of the fixed part of the header of a binary flux file in bytes.
+    The whole header, grid planes included, is padded to a multiple of it
+    so the arrays that follow stay aligned */
+const int FLUX_HEADER_SIZE = 128;
+
+/** number of flux values computed and written at a time */
+const long FLUX_WRITE_BLOCK = 1 << 20;
 
 // function declarations
-void printFluxToFile(std::vector <std::vector <std::vector
-        <std::vector <double> > > > &_flux);
+void writeFluxToFile(Mesh &mesh, std::string file_name);
 
 #endif
@@ -0,0 +1,131 @@
+/*
+ @file      Random_stream.cpp
+ @brief     contains functions for the RandomStream class
+ @author    Luke Eure
+ @date      March 9 2016
+*/
+
+#include "Random_stream.h"
+
+// Philox4x32 multipliers and Weyl key increments
+static const uint32_t PHILOX_M0 = 0xD2511F53;
+static const uint32_t PHILOX_M1 = 0xCD9E8D57;
+static const uint32_t PHILOX_W0 = 0x9E3779B9;
+static const uint32_t PHILOX_W1 = 0xBB67AE85;
+static const int PHILOX_ROUNDS = 10;
+
+/** no block has been generated yet */
+static const uint64_t NO_BLOCK = ~(uint64_t) 0;
+
+/*
+ @brief     default constructor, the stream of history 0 in batch 0 with
+            seed 0
+*/
+RandomStream::RandomStream() {
+    _key[0] = 0;
+    _key[1] = 0;
+    _batch = 0;
+    _history = 0;
+    _position = 0;
+    _cached_block = NO_BLOCK;
+}
+
+/*
+ @brief     constructor for RandomStream class
+ @param     seed the global seed of the run
+ @param     batch the batch number
+ @param     history the history number within the batch
+*/
+RandomStream::RandomStream(uint64_t seed, int batch, int history) {
+    _key[0] = (uint32_t) seed;
+    _key[1] = (uint32_t) (seed >> 32);
+    _batch = batch;
+    _history = history;
+    _position = 0;
+    _cached_block = NO_BLOCK;
+}
+
+/*
+ @brief     deconstructor
+*/
+RandomStream::~RandomStream() {}
+
+/*
+ @brief     returns the next random number in the stream
+ @return    a psuedo-random number in (0, 1)
+*/
+double RandomStream::arand() {
+    uint64_t block = _position >> 1;
+    if (block != _cached_block)
+        generateBlock(block);
+    return _block_values[_position++ & 1];
+}
+
+/*
+ @brief     fills an array with the next random numbers in the stream
+ @param     values the array to fill
+ @param     count the number of random numbers to draw
+*/
+void RandomStream::fill(double* values, int count) {
+    for (int i=0; i<count; ++i)
+        values[i] = arand();
+}
+
+/*
+ @brief     skips over random numbers in the stream without drawing them
+ @param     count the number of random numbers to skip
+*/
+void RandomStream::skipAhead(uint64_t count) {
+    _position += count;
+}
+
+/*
+ @brief     returns the number of random numbers drawn from the stream
+ @return    the position in the stream
+*/
+uint64_t RandomStream::getPosition() {
+    return _position;
+}
+
+/*
+ @brief     moves the stream to a given position
+ @param     position the number of random numbers to count as drawn
+*/
+void RandomStream::setPosition(uint64_t position) {
+    _position = position;
+}
+
+/*
+ @brief     runs the Philox4x32-10 rounds on the counter
+            (block, history, batch) and stores the two random numbers made
+            from the four output words
+ @param     block the block of the stream to generate
+*/
+void RandomStream::generateBlock(uint64_t block) {
+    uint32_t counter[4] = {(uint32_t) block, (uint32_t) (block >> 32),
+        _history, _batch};
+    uint32_t key[2] = {_key[0], _key[1]};
+
+    for (int round=0; round<PHILOX_ROUNDS; ++round) {
+        uint64_t product0 = (uint64_t) PHILOX_M0 * counter[0];
+        uint64_t product1 = (uint64_t) PHILOX_M1 * counter[2];
+        uint32_t hi0 = (uint32_t) (product0 >> 32);
+        uint32_t lo0 = (uint32_t) product0;
+        uint32_t hi1 = (uint32_t) (product1 >> 32);
+        uint32_t lo1 = (uint32_t) product1;
+        counter[0] = hi1 ^ counter[1] ^ key[0];
+        counter[1] = lo1;
+        counter[2] = hi0 ^ counter[3] ^ key[1];
+        counter[3] = lo0;
+        key[0] += PHILOX_W0;
+        key[1] += PHILOX_W1;
+    }
+
+    // use the top 53 bits of each pair of words, offset by half a step so
+    // that neither 0 nor 1 can be drawn
+    for (int i=0; i<2; ++i) {
+        uint64_t bits = ((uint64_t) counter[2*i] << 32) | counter[2*i+1];
+        _block_values[i] = ((bits >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    }
+    _cached_block = block;
+}
@@ -0,0 +1,56 @@
+/*
+ @file      Random_stream.h
+ @brief     contains the RandomStream class
+ @author    Luke Eure
+ @date      March 9 2016
+*/
+
+#ifndef RANDOM_STREAM_H
+#define RANDOM_STREAM_H
+
+#include <stdint.h>
+
+/*
+ @brief     a stream of uniform random numbers from the Philox4x32-10
+            counter-based generator
+ @details   the n-th number of a stream is a pure function of the global
+            seed, the batch, the history and n, so every history draws the
+            same numbers no matter which thread or process runs it, batches
+            use independent streams, and skipping ahead is O(1).
+*/
+class RandomStream {
+
+public:
+    RandomStream();
+    RandomStream(uint64_t seed, int batch, int history);
+    virtual ~RandomStream();
+
+    double arand();
+    void fill(double* values, int count);
+    void skipAhead(uint64_t count);
+    uint64_t getPosition();
+    void setPosition(uint64_t position);
+
+private:
+    void generateBlock(uint64_t block);
+
+    /** key of the generator, the global seed */
+    uint32_t _key[2];
+
+    /** batch number, the top word of the counter */
+    uint32_t _batch;
+
+    /** history number, the third word of the counter */
+    uint32_t _history;
+
+    /** number of random numbers drawn so far */
+    uint64_t _position;
+
+    /** block of the stream stored in _block_values */
+    uint64_t _cached_block;
+
+    /** the two random numbers in the cached block */
+    double _block_values[2];
+};
+
+#endif
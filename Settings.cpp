@@ -0,0 +1,409 @@
+/*
+ @file      Settings.cpp
+ @brief     contains functions for the Settings class
+ @author    Luke Eure
+ @date      March 2 2016
+*/
+
+#include "Settings.h"
+
+/*
+ @brief     constructor for Settings class, sets the default run options
+*/
+Settings::Settings() {
+    _transport_mode = HISTORY_BASED;
+    _delta_tracking = false;
+    _majorant_ratio_limit = 0.2;
+    _seed = 12;
+    _population_control = true;
+    _inactive_batches = 0;
+    _auto_inactive = false;
+    _entropy_window = 5;
+    for (int axis=0; axis<3; ++axis)
+        _entropy_mesh[axis] = 8;
+    _checkpoint_file = "checkpoint.bin";
+    _checkpoint_interval = 0;
+    _geometry = NULL;
+    _cmfd = NULL;
+    _survival_biasing = false;
+    _weight_cutoff = 0.25;
+    _survival_weight = 1.0;
+    _weight_windows = NULL;
+}
+
+/*
+ @brief     deconstructor
+*/
+Settings::~Settings() {}
+
+/*
+ @brief     sets how neutrons are transported
+ @param     mode HISTORY_BASED to follow each neutron from birth to death,
+            EVENT_BASED to advance the whole batch one event at a time
+*/
+void Settings::setTransportMode(TransportMode mode) {
+    _transport_mode = mode;
+}
+
+/*
+ @brief     turns Woodcock delta tracking on or off for history-based
+            transport
+ @param     delta_tracking true to delta track the groups whose majorant
+            ratio is at least the majorant ratio limit
+*/
+void Settings::setDeltaTracking(bool delta_tracking) {
+    _delta_tracking = delta_tracking;
+}
+
+/*
+ @brief     sets the smallest ratio of the minimum to the majorant total
+            cross section in the mesh for which a group is delta tracked.
+            Groups below the limit would mostly sample virtual collisions
+            and are surface tracked instead.
+ @param     ratio_limit the limit, between 0 (delta track every group)
+            and 1 (only groups with a constant cross section)
+*/
+void Settings::setMajorantRatioLimit(double ratio_limit) {
+    _majorant_ratio_limit = ratio_limit;
+}
+
+/*
+ @brief     sets the global random number seed. Runs with the same seed give
+            the same results for any number of threads. Runs on different
+            numbers of processes agree to round-off, as the process sums
+            are added in the order MPI chooses.
+ @param     seed the seed
+*/
+void Settings::setSeed(uint64_t seed) {
+    _seed = seed;
+}
+
+/*
+ @brief     turns population control of the fission source on or off
+ @param     population_control true to comb the fission bank into exactly
+            one source site per history at the start of each batch, false
+            to sample each source site at random from the whole bank
+*/
+void Settings::setPopulationControl(bool population_control) {
+    _population_control = population_control;
+}
+
+/*
+ @brief     sets the number of inactive batches, which converge the fission
+            source without contributing to the crow distance or flux
+            tallies
+ @param     inactive_batches the number of inactive batches, or the least
+            number if the inactive phase ends automatically
+*/
+void Settings::setInactiveBatches(int inactive_batches) {
+    _inactive_batches = inactive_batches;
+}
+
+/*
+ @brief     turns on or off ending the inactive phase automatically once
+            the Shannon entropy of the fission source has settled
+ @param     auto_inactive true to end the inactive phase when the mean
+            entropy of the last window of batches is within one standard
+            deviation of the mean of the window before it
+*/
+void Settings::setAutoInactive(bool auto_inactive) {
+    _auto_inactive = auto_inactive;
+}
+
+/*
+ @brief     sets the number of batches in each window of source entropies
+            compared to detect convergence
+ @param     entropy_window the number of batches in a window
+*/
+void Settings::setEntropyWindow(int entropy_window) {
+    _entropy_window = entropy_window;
+}
+
+/*
+ @brief     sets the coarse mesh over the bounding box on which the Shannon
+            entropy of the fission source is computed
+ @param     x_divisions the number of divisions along the x axis
+ @param     y_divisions the number of divisions along the y axis
+ @param     z_divisions the number of divisions along the z axis
+*/
+void Settings::setEntropyMesh(int x_divisions, int y_divisions,
+        int z_divisions) {
+    _entropy_mesh[0] = x_divisions;
+    _entropy_mesh[1] = y_divisions;
+    _entropy_mesh[2] = z_divisions;
+}
+
+/*
+ @brief     adds a tally to be scored in every active batch of a run. Its
+            mean and standard error over the active batches can be read
+            once the run is done.
+ @param     tally a tally with its filters and scores set, which must
+            outlive the run
+*/
+void Settings::addTally(Tally* tally) {
+    _tallies.push_back(tally);
+}
+
+/*
+ @brief     turns on saving the state of the run every few batches
+ @param     file_name the name of the checkpoint file, overwritten by each
+            checkpoint
+ @param     interval the number of batches between checkpoints, or 0 to
+            turn checkpoints off. The last batch is always saved.
+*/
+void Settings::setCheckpoint(std::string file_name, int interval) {
+    _checkpoint_file = file_name;
+    _checkpoint_interval = interval;
+}
+
+/*
+ @brief     resumes a run from a checkpoint, carrying on after the batch it
+            was written in with its tallies, flux and fission bank
+ @param     file_name the name of the checkpoint file, or an empty string
+            to start a new run
+*/
+void Settings::setRestartFile(std::string file_name) {
+    _restart_file = file_name;
+}
+
+/*
+ @brief     starts a new run from the fission bank of a checkpoint, so a
+            source converged by an earlier run needs no inactive batches
+ @param     file_name the name of the checkpoint file, or an empty string
+            to start from a uniform source
+*/
+void Settings::setSourceFile(std::string file_name) {
+    _source_file = file_name;
+}
+
+/*
+ @brief     tracks neutrons through cells bounded by surfaces instead of the
+            mesh cells. The mesh still holds the flux and bins the tallies,
+            but its materials are not used. Neutrons are transported history
+            by history with surface tracking.
+ @param     geometry the cells, which must fill the bounding box and outlive
+            the run, or NULL to track through the mesh
+*/
+void Settings::setGeometry(Geometry* geometry) {
+    _geometry = geometry;
+}
+
+/*
+ @brief     accelerates the convergence of the fission source with coarse
+            mesh finite difference. Each inactive batch the coarse mesh
+            diffusion problem is solved from the tallies of all batches so
+            far and the fission bank is reweighted to its fission source.
+            Needs neutrons surface tracked through the mesh, so it is not
+            used with a geometry or delta tracking.
+ @param     cmfd the coarse mesh, which must outlive the run, or NULL for
+            plain power iteration
+*/
+void Settings::setCmfd(Cmfd* cmfd) {
+    _cmfd = cmfd;
+}
+
+/*
+ @brief     turns survival biasing on or off. A survival biased neutron is
+            never absorbed: each collision scores the absorbed part of its
+            weight and the rest scatters, and the fission neutrons it would
+            produce are banked in expectation. Neutrons whose weight falls
+            below the weight cutoff play Russian roulette.
+ @param     survival_biasing true for implicit capture, false for analog
+            absorption
+*/
+void Settings::setSurvivalBiasing(bool survival_biasing) {
+    _survival_biasing = survival_biasing;
+}
+
+/*
+ @brief     sets the Russian roulette played by survival biased neutrons.
+            A neutron below the cutoff survives with probability
+            weight / survival_weight and takes the survival weight, so the
+            expected weight is kept.
+ @param     weight_cutoff the weight below which neutrons play roulette
+ @param     survival_weight the weight of the neutrons that survive, above
+            the cutoff
+*/
+void Settings::setWeightCutoff(double weight_cutoff, double survival_weight) {
+    if (weight_cutoff <= 0.0 || survival_weight <= weight_cutoff) {
+        std::cout << "The survival weight must be above a positive weight "
+            << "cutoff" << std::endl;
+        return;
+    }
+    _weight_cutoff = weight_cutoff;
+    _survival_weight = survival_weight;
+}
+
+/*
+ @brief     sets weight windows on the mesh cells, which split neutrons
+            above them and roulette neutrons below them at every collision
+            and mesh surface crossing. They take the place of the weight
+            cutoff of survival biased neutrons.
+ @param     weight_windows the weight windows, or NULL for none
+*/
+void Settings::setWeightWindows(WeightWindows* weight_windows) {
+    _weight_windows = weight_windows;
+}
+
+/*
+ @brief     returns how neutrons are transported
+ @return    the transport mode
+*/
+TransportMode Settings::getTransportMode() {
+    return _transport_mode;
+}
+
+/*
+ @brief     returns whether delta tracking is turned on
+ @return    true if delta tracking may be used
+*/
+bool Settings::getDeltaTracking() {
+    return _delta_tracking;
+}
+
+/*
+ @brief     returns the smallest majorant ratio for which a group is delta
+            tracked
+ @return    the majorant ratio limit
+*/
+double Settings::getMajorantRatioLimit() {
+    return _majorant_ratio_limit;
+}
+
+/*
+ @brief     returns the global random number seed
+ @return    the seed
+*/
+uint64_t Settings::getSeed() {
+    return _seed;
+}
+
+/*
+ @brief     returns whether the fission bank is combed
+ @return    true if population control is on
+*/
+bool Settings::getPopulationControl() {
+    return _population_control;
+}
+
+/*
+ @brief     returns the number of inactive batches
+ @return    the number of inactive batches
+*/
+int Settings::getInactiveBatches() {
+    return _inactive_batches;
+}
+
+/*
+ @brief     returns whether the inactive phase ends automatically
+ @return    true if the inactive phase ends once the source entropy settles
+*/
+bool Settings::getAutoInactive() {
+    return _auto_inactive;
+}
+
+/*
+ @brief     returns the number of batches in a window of source entropies
+ @return    the entropy window
+*/
+int Settings::getEntropyWindow() {
+    return _entropy_window;
+}
+
+/*
+ @brief     returns the divisions of the source entropy mesh
+ @return    an array of the number of divisions along each axis
+*/
+int* Settings::getEntropyMesh() {
+    return _entropy_mesh;
+}
+
+/*
+ @brief     returns the tallies scored in each run
+ @return    a vector of pointers to the tallies
+*/
+std::vector <Tally*>& Settings::getTallies() {
+    return _tallies;
+}
+
+/*
+ @brief     returns the name of the checkpoint file
+ @return    the file name
+*/
+std::string Settings::getCheckpointFile() {
+    return _checkpoint_file;
+}
+
+/*
+ @brief     returns the number of batches between checkpoints
+ @return    the interval, 0 if checkpoints are off
+*/
+int Settings::getCheckpointInterval() {
+    return _checkpoint_interval;
+}
+
+/*
+ @brief     returns the checkpoint a run resumes from
+ @return    the file name, empty for a new run
+*/
+std::string Settings::getRestartFile() {
+    return _restart_file;
+}
+
+/*
+ @brief     returns the checkpoint whose fission bank starts a new run
+ @return    the file name, empty for a uniform source
+*/
+std::string Settings::getSourceFile() {
+    return _source_file;
+}
+
+/*
+ @brief     returns the cells neutrons are tracked through
+ @return    a pointer to the geometry, or NULL if neutrons are tracked
+            through the mesh
+*/
+Geometry* Settings::getGeometry() {
+    return _geometry;
+}
+
+/*
+ @brief     returns the coarse mesh the fission source is accelerated on
+ @return    a pointer to the coarse mesh, or NULL for none
+*/
+Cmfd* Settings::getCmfd() {
+    return _cmfd;
+}
+
+/*
+ @brief     returns whether neutrons are survival biased
+ @return    true for implicit capture, false for analog absorption
+*/
+bool Settings::getSurvivalBiasing() {
+    return _survival_biasing;
+}
+
+/*
+ @brief     returns the weight below which neutrons play Russian roulette
+ @return    the weight cutoff
+*/
+double Settings::getWeightCutoff() {
+    return _weight_cutoff;
+}
+
+/*
+ @brief     returns the weight given to neutrons that survive Russian
+            roulette
+ @return    the survival weight
+*/
+double Settings::getSurvivalWeight() {
+    return _survival_weight;
+}
+
+/*
+ @brief     returns the weight windows on the mesh cells
+ @return    a pointer to the weight windows, or NULL for none
+*/
+WeightWindows* Settings::getWeightWindows() {
+    return _weight_windows;
+}
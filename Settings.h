@@ -0,0 +1,141 @@
+/*
+ @file      Settings.h
+ @brief     contains the Settings class
+ @author    Luke Eure
+ @date      March 2 2016
+*/
+
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+// ways a batch of neutrons can be transported
+enum TransportMode {
+    HISTORY_BASED,
+    EVENT_BASED
+};
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include "Tally.h"
+#include "Geometry.h"
+#include "Cmfd.h"
+#include "Weight_windows.h"
+
+class Settings {
+
+public:
+    Settings();
+    virtual ~Settings();
+
+    void setTransportMode(TransportMode mode);
+    void setDeltaTracking(bool delta_tracking);
+    void setMajorantRatioLimit(double ratio_limit);
+    void setSeed(uint64_t seed);
+    void setPopulationControl(bool population_control);
+    void setInactiveBatches(int inactive_batches);
+    void setAutoInactive(bool auto_inactive);
+    void setEntropyWindow(int entropy_window);
+    void setEntropyMesh(int x_divisions, int y_divisions, int z_divisions);
+    void addTally(Tally* tally);
+    void setCheckpoint(std::string file_name, int interval);
+    void setRestartFile(std::string file_name);
+    void setSourceFile(std::string file_name);
+    void setGeometry(Geometry* geometry);
+    void setCmfd(Cmfd* cmfd);
+    void setSurvivalBiasing(bool survival_biasing);
+    void setWeightCutoff(double weight_cutoff, double survival_weight);
+    void setWeightWindows(WeightWindows* weight_windows);
+    TransportMode getTransportMode();
+    bool getDeltaTracking();
+    double getMajorantRatioLimit();
+    uint64_t getSeed();
+    bool getPopulationControl();
+    int getInactiveBatches();
+    bool getAutoInactive();
+    int getEntropyWindow();
+    int* getEntropyMesh();
+    std::vector <Tally*>& getTallies();
+    std::string getCheckpointFile();
+    int getCheckpointInterval();
+    std::string getRestartFile();
+    std::string getSourceFile();
+    Geometry* getGeometry();
+    Cmfd* getCmfd();
+    bool getSurvivalBiasing();
+    double getWeightCutoff();
+    double getSurvivalWeight();
+    WeightWindows* getWeightWindows();
+
+private:
+
+    /** whether neutrons are followed one at a time or in event stages */
+    TransportMode _transport_mode;
+
+    /** whether history-based transport may use Woodcock delta tracking */
+    bool _delta_tracking;
+
+    /** smallest ratio of the minimum to the majorant total cross section
+        for which a group is delta tracked */
+    double _majorant_ratio_limit;
+
+    /** global random number seed, the key of every neutron's stream */
+    uint64_t _seed;
+
+    /** whether the fission bank is combed to a fixed number of sites */
+    bool _population_control;
+
+    /** number of batches run to converge the source before tallying, the
+        least number if the inactive phase ends automatically */
+    int _inactive_batches;
+
+    /** whether the inactive phase ends once the source entropy settles */
+    bool _auto_inactive;
+
+    /** number of batches in each window compared to detect a settled
+        source entropy */
+    int _entropy_window;
+
+    /** number of divisions of the bounding box along each axis in the
+        mesh the source entropy is computed on */
+    int _entropy_mesh[3];
+
+    /** tallies scored in every active batch of a run */
+    std::vector <Tally*> _tallies;
+
+    /** file the state of the run is saved to */
+    std::string _checkpoint_file;
+
+    /** number of batches between checkpoints, or 0 for none */
+    int _checkpoint_interval;
+
+    /** checkpoint a run resumes from, or empty to start a new run */
+    std::string _restart_file;
+
+    /** checkpoint whose fission bank is the first source of a new run, or
+        empty to start from a uniform source */
+    std::string _source_file;
+
+    /** cells neutrons are tracked through instead of the mesh, or NULL to
+        track through the mesh */
+    Geometry* _geometry;
+
+    /** coarse mesh the fission source is accelerated on during inactive
+        batches, or NULL for none */
+    Cmfd* _cmfd;
+
+    /** whether collisions reduce a neutron's weight by the absorption
+        probability instead of sampling absorption */
+    bool _survival_biasing;
+
+    /** weight below which a survival biased neutron plays Russian
+        roulette, and the weight it is given if it survives */
+    double _weight_cutoff;
+    double _survival_weight;
+
+    /** weight windows on the mesh cells, or NULL for none */
+    WeightWindows* _weight_windows;
+};
+
+#endif
@@ -15,6 +15,52 @@
 Surface::Surface(BoundaryType type, double position) {
     _boundary_type = type;
     _position = position;
+    setAxis(X);
+}
+
+/*
+ @brief constructor for a Surface of any shape
+ @param kind the shape of the surface
+ @param parameters for X_PLANE, Y_PLANE and Z_PLANE the position of the
+        plane; for PLANE a, b, c and d of the plane a x + b y + c z = d;
+        for Z_CYLINDER the x and y of its axis and its radius
+ @param type the type of boundary, BOUNDARY_NONE for a surface inside the
+        geometry
+*/
+Surface::Surface(SurfaceKind kind, double* parameters, BoundaryType type) {
+    _boundary_type = type;
+    _kind = kind;
+    _position = 0.0;
+    for (int i=0; i<NUM_SURFACE_COEFFICIENTS; ++i)
+        _coefficients[i] = 0.0;
+    switch (kind) {
+        case X_PLANE:
+        case Y_PLANE:
+        case Z_PLANE:
+            _position = parameters[0];
+            setAxis((Axes) (kind - X_PLANE));
+            break;
+        case PLANE: {
+            double norm = sqrt(parameters[0] * parameters[0]
+                    + parameters[1] * parameters[1]
+                    + parameters[2] * parameters[2]);
+            if (norm == 0.0) {
+                std::cout << "A plane needs a nonzero normal" << std::endl;
+                norm = 1.0;
+            }
+            for (int i=0; i<3; ++i)
+                _coefficients[1 + i] = parameters[i] / norm;
+            _coefficients[4] = -parameters[3] / norm;
+            break;
+        }
+        case Z_CYLINDER:
+            _coefficients[0] = 1.0;
+            _coefficients[1] = -2.0 * parameters[0];
+            _coefficients[2] = -2.0 * parameters[1];
+            _coefficients[4] = parameters[0] * parameters[0]
+                + parameters[1] * parameters[1] - parameters[2] * parameters[2];
+            break;
+    }
 }
 
 /*
@@ -37,3 +83,61 @@ double Surface::getPosition() {
 BoundaryType Surface::getType() {
     return _boundary_type;
 }
+
+/*
+ @brief returns the shape of the surface
+ @return the kind of surface
+*/
+SurfaceKind Surface::getKind() {
+    return _kind;
+}
+
+/*
+ @brief makes the surface a plane normal to an axis at its position, as the
+        Boundaries do with the surfaces of the bounding box
+ @param axis the axis normal to the plane
+*/
+void Surface::setAxis(Axes axis) {
+    _kind = (SurfaceKind) (X_PLANE + axis);
+    for (int i=0; i<NUM_SURFACE_COEFFICIENTS; ++i)
+        _coefficients[i] = 0.0;
+    _coefficients[1 + axis] = 1.0;
+    _coefficients[4] = -_position;
+}
+
+/*
+ @brief returns the coefficients of the surface function
+ @param coefficients an array to fill with a, b, c, d and e
+*/
+void Surface::getCoefficients(double* coefficients) {
+    for (int i=0; i<NUM_SURFACE_COEFFICIENTS; ++i)
+        coefficients[i] = _coefficients[i];
+}
+
+/*
+ @brief evaluates the surface function at a point
+ @param position the point
+ @return the value of the function, positive on the surface's positive side
+*/
+double Surface::evaluate(double* position) {
+    double* k = _coefficients;
+    return k[0] * (position[0] * position[0] + position[1] * position[1])
+        + k[1] * position[0] + k[2] * position[1] + k[3] * position[2] + k[4];
+}
+
+/*
+ @brief finds the unit normal of the surface at a point, pointing to its
+        positive side
+ @param position a point on the surface
+ @param normal an array to fill with the normal
+*/
+void Surface::getNormal(double* position, double* normal) {
+    double* k = _coefficients;
+    normal[0] = 2.0 * k[0] * position[0] + k[1];
+    normal[1] = 2.0 * k[0] * position[1] + k[2];
+    normal[2] = k[3];
+    double norm = sqrt(normal[0] * normal[0] + normal[1] * normal[1]
+            + normal[2] * normal[2]);
+    for (int axis=0; axis<3; ++axis)
+        normal[axis] /= norm;
+}
@@ -8,6 +8,9 @@
 #ifndef Surface_H
 #define Surface_H
 
+#include <iostream>
+#include <math.h>
+
 enum BoundaryType {
     VACUUM,
     REFLECTIVE,
@@ -23,22 +26,56 @@ enum Axes {
     Z
 };
 
+// shapes of surface
+enum SurfaceKind {
+    X_PLANE,
+    Y_PLANE,
+    Z_PLANE,
+    PLANE,
+    Z_CYLINDER
+};
+
+/** number of coefficients describing a surface */
+const int NUM_SURFACE_COEFFICIENTS = 5;
+
+/*
+ @brief     a plane or z-cylinder, which may be a boundary of the geometry
+ @details   every surface is the set of points where
+            f(x, y, z) = a (x^2 + y^2) + b x + c y + d z + e
+            is zero, with a = 0 for planes and a = 1 for z-cylinders, so the
+            distance to any surface is found by the same arithmetic. Points
+            where f is positive are on the surface's positive side: above a
+            plane along its normal, or outside a cylinder.
+*/
 class Surface {
 
 public:
     Surface(BoundaryType type, double position);
+    Surface(SurfaceKind kind, double* parameters,
+            BoundaryType type=BOUNDARY_NONE);
     virtual ~Surface();
 
     double getPosition();
     BoundaryType getType();
+    SurfaceKind getKind();
+    void setAxis(Axes axis);
+    void getCoefficients(double* coefficients);
+    double evaluate(double* position);
+    void getNormal(double* position, double* normal);
 
 private:
 
     /** the type of the boundary, vacuum, reflective, or none */
     BoundaryType _boundary_type;
 
-    /** the position of the boundary */
+    /** the position of the boundary, for an axis plane */
     double _position;
+
+    /** the shape of the surface */
+    SurfaceKind _kind;
+
+    /** the coefficients a, b, c, d and e of the surface function */
+    double _coefficients[NUM_SURFACE_COEFFICIENTS];
 };
 
 
@@ -1,4 +1,4 @@
-/* 
+/*
  @file      Tally.cpp
  @brief     contains functions for the Tally class
  @author    Luke Eure
@@ -8,9 +8,23 @@
 #include "Tally.h"
 
 /*
- @brief     constructor for Tally class
+ @brief     constructor for Tally class, making a tally with a single bin
+            and no scores
 */
-Tally::Tally() {}
+Tally::Tally() {
+    _scores_tracks = false;
+    _scores_crossings = false;
+    _num_bins = 1;
+    _mesh_stride = 0;
+    _surface_stride = 0;
+    _group_stride = 0;
+    _material_stride = 0;
+    _num_batches = 0;
+    for (int axis=0; axis<3; ++axis) {
+        _mesh_size[axis] = 0;
+        _face_offsets[axis] = 0;
+    }
+}
 
 /*
  @brief     deconstructor
@@ -18,39 +32,450 @@ Tally::Tally() {}
 Tally::~Tally() {}
 
 /*
- @brief     sets the tally and _tally_squared equal to zero
+ @brief     splits the tally by the mesh cell scored in
+ @param     x_cells the number of mesh cells along the x axis
+ @param     y_cells the number of mesh cells along the y axis
+ @param     z_cells the number of mesh cells along the z axis
+*/
+void Tally::addMeshFilter(int x_cells, int y_cells, int z_cells) {
+    _mesh_size[0] = x_cells;
+    _mesh_size[1] = y_cells;
+    _mesh_size[2] = z_cells;
+    _mesh_stride = _num_bins;
+    _num_bins *= (long) x_cells * y_cells * z_cells;
+    resize();
+}
+
+/*
+ @brief     splits the tally by the mesh cell surface crossed, for current
+            scores. Faces normal to each axis are stored together. A tally
+            filtered by surface scores no track scores, and is not also
+            filtered by mesh cell. Crossings are only seen while neutrons
+            are surface tracked through the mesh, not through a Geometry
+            or in delta tracked groups.
+ @param     x_cells the number of mesh cells along the x axis
+ @param     y_cells the number of mesh cells along the y axis
+ @param     z_cells the number of mesh cells along the z axis
+*/
+void Tally::addSurfaceFilter(int x_cells, int y_cells, int z_cells) {
+    _mesh_size[0] = x_cells;
+    _mesh_size[1] = y_cells;
+    _mesh_size[2] = z_cells;
+    long num_faces = 0;
+    for (int axis=0; axis<3; ++axis) {
+        _face_offsets[axis] = num_faces;
+        long axis_faces = 1;
+        for (int a=0; a<3; ++a)
+            axis_faces *= _mesh_size[a] + (a == axis);
+        num_faces += axis_faces;
+    }
+    _surface_stride = _num_bins;
+    _num_bins *= num_faces;
+    resize();
+}
+
+/*
+ @brief     splits the tally by the energy group scored in
+ @param     num_groups the number of neutron energy groups
+*/
+void Tally::addGroupFilter(int num_groups) {
+    _group_stride = _num_bins;
+    _num_bins *= num_groups;
+    resize();
+}
+
+/*
+ @brief     splits the tally by the material scored in. Scores in other
+            materials are not tallied.
+ @param     materials the materials to bin
+*/
+void Tally::addMaterialFilter(std::vector <Material*> &materials) {
+    _materials = materials;
+    _material_stride = _num_bins;
+    _num_bins *= materials.size();
+    resize();
+}
+
+/*
+ @brief     adds a quantity to score in every bin
+ @param     score the type of score, EVENT_SCORE for a quantity credited
+            with add(), a current score for the number of neutrons crossing
+            a surface, and the others for a flux or reaction rate
+*/
+void Tally::addScore(ScoreType score) {
+    _scores.push_back(score);
+    if (score == NET_CURRENT_SCORE || score == POSITIVE_CURRENT_SCORE
+            || score == NEGATIVE_CURRENT_SCORE)
+        _scores_crossings = true;
+    else if (score != EVENT_SCORE)
+        _scores_tracks = true;
+    resize();
+}
+
+/*
+ @brief     returns the number of scores in each bin
+ @return    the number of scores
+*/
+int Tally::getNumScores() {
+    return _scores.size();
+}
+
+/*
+ @brief     returns the number of values held by the tally
+ @return    the number of bins times the number of scores
+*/
+long Tally::getSize() {
+    return _batch.size();
+}
+
+/*
+ @brief     finds where a score is stored
+ @param     cell the mesh cell, used if the tally is filtered by mesh cell
+ @param     group the energy group, used if filtered by group
+ @param     material the material, used if filtered by material
+ @param     score the position of the score in the order they were added
+ @return    the index of the value, or -1 if the material is not binned
+*/
+long Tally::getIndex(int* cell, int group, Material* material, int score) {
+    long bin = getBin(cell, group, material);
+    if (bin < 0)
+        return -1;
+    return bin * _scores.size() + score;
+}
+
+/*
+ @brief     finds where a score of a mesh cell surface is stored in a tally
+            filtered by surface
+ @param     cell a mesh cell the surface bounds
+ @param     axis the axis normal to the surface
+ @param     side the side of the cell the surface is on
+ @param     group the energy group, used if filtered by group
+ @param     material the material, used if filtered by material
+ @param     score the position of the score in the order they were added
+ @return    the index of the value, or -1 if the material is not binned
+*/
+long Tally::getFaceIndex(int* cell, int axis, int side, int group,
+        Material* material, int score) {
+    long bin = getFaceBin(cell, axis, side, group, material);
+    if (bin < 0)
+        return -1;
+    return bin * _scores.size() + score;
+}
+
+/*
+ @brief     credits every track score with an estimate of the flux
+ @param     cell the mesh cell of the neutron
+ @param     group the energy group of the neutron
+ @param     material the material the flux was estimated in
+ @param     flux the estimate of the flux, a track length or collision
+            estimate
+*/
+void Tally::score(int* cell, int group, Material* material, double flux) {
+    if (!_scores_tracks)
+        return;
+    long bin = getBin(cell, group, material);
+    if (bin < 0)
+        return;
+    double* values = &_batch[bin * _scores.size()];
+    for (int s=0; s<_scores.size(); ++s) {
+        switch (_scores[s]) {
+            case EVENT_SCORE:
+                break;
+            case FLUX_SCORE:
+                values[s] += flux;
+                break;
+            case TOTAL_SCORE:
+                values[s] += flux * material->getSigmaT(group);
+                break;
+            case ABSORPTION_SCORE:
+                values[s] += flux * material->getSigmaA(group);
+                break;
+            case FISSION_SCORE:
+                values[s] += flux * material->getSigmaF(group);
+                break;
+            case NU_FISSION_SCORE:
+                values[s] += flux * material->getNu()
+                    * material->getSigmaF(group);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/*
+ @brief     credits every current score with a neutron crossing a mesh cell
+            surface. In a tally filtered by mesh cell rather than surface,
+            the crossing is binned by the cell whose surface it is.
+ @param     cell the mesh cell whose surface is crossed
+ @param     axis the axis normal to the surface
+ @param     side the side of the cell the surface is on
+ @param     direction the component of the neutron's direction along the
+            axis, whose sign sets which partial current is credited
+ @param     group the energy group of the neutron
+ @param     material the material of the cell
+ @param     value the amount to credit, 1 for one neutron
+*/
+void Tally::scoreCrossing(int* cell, int axis, int side, double direction,
+        int group, Material* material, double value) {
+    if (!_scores_crossings)
+        return;
+    long bin = getFaceBin(cell, axis, side, group, material);
+    if (bin < 0)
+        return;
+    double* values = &_batch[bin * _scores.size()];
+    bool positive = direction > 0.0;
+    for (int s=0; s<_scores.size(); ++s) {
+        switch (_scores[s]) {
+            case NET_CURRENT_SCORE:
+                values[s] += positive ? value : -value;
+                break;
+            case POSITIVE_CURRENT_SCORE:
+                if (positive)
+                    values[s] += value;
+                break;
+            case NEGATIVE_CURRENT_SCORE:
+                if (!positive)
+                    values[s] += value;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/*
+ @brief     adds an amount to a value of the current batch
+ @param     index the index of the value
+ @param     value the amount to add
+*/
+void Tally::add(long index, double value) {
+    _batch[index] += value;
+}
+
+/*
+ @brief     adds the current batch of another tally to this one, used to
+            reduce thread-private tallies at the end of a batch
+ @param     tally_addition a tally with the same filters and scores
+*/
+void Tally::merge(Tally &tally_addition) {
+    for (long i=0; i<_batch.size(); ++i)
+        _batch[i] += tally_addition._batch[i];
+}
+
+/*
+ @brief     sets the values of the current batch to zero
 */
 void Tally::clear() {
-    _tally_count = 0;
-    _tally_squared = 0;
+    for (long i=0; i<_batch.size(); ++i)
+        _batch[i] = 0.0;
+}
+
+/*
+ @brief     adds the totals of the current batch to the statistics and
+            clears them for the next batch
+*/
+void Tally::endBatch() {
+    for (long i=0; i<_batch.size(); ++i) {
+        _sum[i] += _batch[i];
+        _sum_squared[i] += _batch[i] * _batch[i];
+        _batch[i] = 0.0;
+    }
+    _num_batches++;
+}
+
+/*
+ @brief     returns the values of the current batch, stored contiguously
+ @return    a pointer to the first value
+*/
+double* Tally::getBatchValues() {
+    return &_batch[0];
+}
+
+/*
+ @brief     returns a value of the current batch
+ @param     index the index of the value
+ @return    the amount scored in the current batch
+*/
+double Tally::getBatchValue(long index) {
+    return _batch[index];
+}
+
+/*
+ @brief     returns the number of batches in the statistics
+ @return    the number of batches ended
+*/
+int Tally::getNumBatches() {
+    return _num_batches;
+}
+
+/*
+ @brief     sets the number of batches in the statistics, used when they
+            are restored from a checkpoint
+ @param     num_batches the number of batches summed
+*/
+void Tally::setNumBatches(int num_batches) {
+    _num_batches = num_batches;
+}
+
+/*
+ @brief     returns the sums of the batch values, stored contiguously
+ @return    a pointer to the first of getSize() sums
+*/
+double* Tally::getSums() {
+    return &_sum[0];
 }
- 
+
+/*
+ @brief     returns the sums of the squares of the batch values
+ @return    a pointer to the first of getSize() sums of squares
+*/
+double* Tally::getSquaredSums() {
+    return &_sum_squared[0];
+}
+
+/*
+ @brief     returns the mean of a value over the batches
+ @param     index the index of the value
+ @return    the mean batch total
+*/
+double Tally::getMean(long index) {
+    return _sum[index] / _num_batches;
+}
+
+/*
+ @brief     returns the standard error of the mean of a value, estimated
+            from the spread of the batch totals
+ @param     index the index of the value
+ @return    the standard error, or 0 if fewer than two batches were ended
+*/
+double Tally::getStandardError(long index) {
+    if (_num_batches < 2)
+        return 0.0;
+    double mean = _sum[index] / _num_batches;
+    double variance = _sum_squared[index] / _num_batches - mean * mean;
+    if (variance < 0.0)
+        variance = 0.0;
+    return sqrt(variance / (_num_batches - 1));
+}
+
+/*
+ @brief     finds the combination of filter bins a score falls in
+ @param     cell the mesh cell
+ @param     group the energy group
+ @param     material the material
+ @return    the bin, or -1 if the material is not binned or the tally is
+            filtered by surface
+*/
+long Tally::getBin(int* cell, int group, Material* material) {
+    if (_surface_stride > 0)
+        return -1;
+    long bin = getFilterBin(group, material);
+    if (bin < 0)
+        return -1;
+    if (_mesh_stride > 0) {
+        bin += _mesh_stride * (((long) cell[0] * _mesh_size[1] + cell[1])
+                * _mesh_size[2] + cell[2]);
+    }
+    return bin;
+}
+
+/*
+ @brief     finds the combination of filter bins a score on a mesh cell
+            surface falls in
+ @param     cell a mesh cell the surface bounds
+ @param     axis the axis normal to the surface
+ @param     side the side of the cell the surface is on
+ @param     group the energy group
+ @param     material the material
+ @return    the bin, or -1 if the material is not binned
+*/
+long Tally::getFaceBin(int* cell, int axis, int side, int group,
+        Material* material) {
+    if (_surface_stride == 0)
+        return getBin(cell, group, material);
+    long bin = getFilterBin(group, material);
+    if (bin < 0)
+        return -1;
+
+    // number the face like a cell of a mesh with one more plane along the
+    // axis
+    int face[3] = {cell[0], cell[1], cell[2]};
+    int sizes[3] = {_mesh_size[0], _mesh_size[1], _mesh_size[2]};
+    face[axis] += side == MAX;
+    sizes[axis]++;
+    return bin + _surface_stride * (_face_offsets[axis]
+            + ((long) face[0] * sizes[1] + face[1]) * sizes[2] + face[2]);
+}
+
+/*
+ @brief     finds the combination of the group and material filter bins a
+            score falls in
+ @param     group the energy group
+ @param     material the material
+ @return    the bin, or -1 if the material is not binned
+*/
+long Tally::getFilterBin(int group, Material* material) {
+    long bin = 0;
+    if (_group_stride > 0)
+        bin += _group_stride * group;
+    if (_material_stride > 0) {
+        int m = 0;
+        while (m < _materials.size() && _materials[m] != material)
+            m++;
+        if (m == _materials.size())
+            return -1;
+        bin += _material_stride * m;
+    }
+    return bin;
+}
+
 /*
-  @brief    gets the current tally count
-  @return   a double: the number stored in the tally
+ @brief     sizes the value arrays for the filters and scores added so far,
+            clearing them
 */
-double Tally::getCount() {
-    return _tally_count;
+void Tally::resize() {
+    long size = _num_bins * _scores.size();
+    _batch.assign(size, 0.0);
+    _sum.assign(size, 0.0);
+    _sum_squared.assign(size, 0.0);
+    _num_batches = 0;
 }
 
 /*
-  @brief    returns the standard deviation from the amount held in the tally
-  @param    n the number of sampled data points
-  @return   the standard deviation from the amount held in the tally
+ @brief     credits the track scores of every tally with an estimate of the
+            flux
+ @param     tallies the tallies to score
+ @param     cell the mesh cell of the neutron
+ @param     group the energy group of the neutron
+ @param     material the material the flux was estimated in
+ @param     flux the estimate of the flux, a track length or collision
+            estimate
 */
-double Tally::getStandardDeviation(int n) {
-    double standardDev = 
-        _tally_squared/n - (_tally_count / n) * (_tally_count / n);
-    return standardDev;
+void scoreTallies(std::vector <Tally> &tallies, int* cell, int group,
+        Material* material, double flux) {
+    for (int t=0; t<tallies.size(); ++t)
+        tallies[t].score(cell, group, material, flux);
 }
 
 /*
- @brief     overload for += that allows an amount to be added to the tally. Its
-            square is added to _tally_squared
- @param     tally_addition an amount to be added
+ @brief     credits the current scores of every tally with a neutron
+            crossing a mesh cell surface
+ @param     tallies the tallies to score
+ @param     cell the mesh cell whose surface is crossed
+ @param     axis the axis normal to the surface
+ @param     side the side of the cell the surface is on
+ @param     direction the component of the neutron's direction along the
+            axis
+ @param     group the energy group of the neutron
+ @param     material the material of the cell
+ @param     value the amount to credit, 1 for one neutron
 */
-Tally Tally::operator+=(double tally_addition) {
-    _tally_count += tally_addition;
-    _tally_squared += tally_addition * tally_addition;
-    return *this;
+void scoreCrossingTallies(std::vector <Tally> &tallies, int* cell, int axis,
+        int side, double direction, int group, Material* material,
+        double value) {
+    for (int t=0; t<tallies.size(); ++t) {
+        tallies[t].scoreCrossing(cell, axis, side, direction, group,
+                material, value);
+    }
 }
@@ -1,4 +1,4 @@
-/* 
+/*
  @file      Tally.h
  @brief     contains Tally class
  @author    Luke Eure
@@ -8,24 +8,125 @@
 #ifndef TALLY_H
 #define TALLY_H
 
+#include <vector>
+#include <math.h>
+
+#include "Material.h"
+#include "Surface.h"
+
+// quantities a tally can score
+enum ScoreType {
+    EVENT_SCORE,
+    FLUX_SCORE,
+    TOTAL_SCORE,
+    ABSORPTION_SCORE,
+    FISSION_SCORE,
+    NU_FISSION_SCORE,
+    NET_CURRENT_SCORE,
+    POSITIVE_CURRENT_SCORE,
+    NEGATIVE_CURRENT_SCORE
+};
+
+/*
+ @brief     scores quantities into bins set by a set of filters, and keeps
+            their mean and standard error over batches
+ @details   each filter splits the tally by mesh cell, energy group or
+            material. Every combination of filter bins holds one value per
+            score, all stored in one contiguous array with the scores
+            fastest varying, then the bins of the first filter added, then
+            the second and so on. Track scores are credited with an estimate
+            of the flux (a track length or a collision estimate) times the
+            matching cross section of the material; current scores are
+            credited each time a neutron crosses a mesh cell surface; event
+            scores are credited directly with add(). Values are summed over
+            a batch, then endBatch() folds the batch total into the
+            statistics.
+*/
 class Tally {
 
-public:    
+public:
     Tally();
     virtual ~Tally();
-    
+
+    void addMeshFilter(int x_cells, int y_cells, int z_cells);
+    void addSurfaceFilter(int x_cells, int y_cells, int z_cells);
+    void addGroupFilter(int num_groups);
+    void addMaterialFilter(std::vector <Material*> &materials);
+    void addScore(ScoreType score);
+    int getNumScores();
+    long getSize();
+    long getIndex(int* cell, int group, Material* material, int score);
+    long getFaceIndex(int* cell, int axis, int side, int group,
+            Material* material, int score);
+    void score(int* cell, int group, Material* material, double flux);
+    void scoreCrossing(int* cell, int axis, int side, double direction,
+            int group, Material* material, double value);
+    void add(long index, double value);
+    void merge(Tally &tally_addition);
     void clear();
-    double getCount();
-    double getStandardDeviation(int n);
-    Tally operator+=(double tally_addition);
+    void endBatch();
+    double* getBatchValues();
+    double getBatchValue(long index);
+    int getNumBatches();
+    void setNumBatches(int num_batches);
+    double* getSums();
+    double* getSquaredSums();
+    double getMean(long index);
+    double getStandardError(long index);
 
 private:
+    long getBin(int* cell, int group, Material* material);
+    long getFaceBin(int* cell, int axis, int side, int group,
+            Material* material);
+    long getFilterBin(int group, Material* material);
+    void resize();
+
+    /** quantities scored in each bin */
+    std::vector <ScoreType> _scores;
+
+    /** whether any score is credited with the flux */
+    bool _scores_tracks;
 
-    /** count stored in the tally */
-    double _tally_count;
+    /** whether any score is credited at surface crossings */
+    bool _scores_crossings;
 
-    /** sum of squares of tallied amounts */
-    double _tally_squared;
+    /** number of combinations of filter bins */
+    long _num_bins;
+
+    /** number of mesh cells along each axis, if filtered by mesh cell or
+        surface */
+    int _mesh_size[3];
+
+    /** the first face normal to each axis in the face numbering, if
+        filtered by surface. The faces normal to an axis are numbered like
+        mesh cells, with one more plane than cells along that axis. */
+    long _face_offsets[3];
+
+    /** distance between consecutive bins of each filter in the bin index,
+        or 0 if the tally is not filtered that way */
+    long _mesh_stride;
+    long _surface_stride;
+    long _group_stride;
+    long _material_stride;
+
+    /** materials binned by the material filter */
+    std::vector <Material*> _materials;
+
+    /** values scored in the current batch */
+    std::vector <double> _batch;
+
+    /** sums of the batch values and of their squares */
+    std::vector <double> _sum;
+    std::vector <double> _sum_squared;
+
+    /** number of batches folded into the statistics */
+    int _num_batches;
 };
 
+void scoreTallies(std::vector <Tally> &tallies, int* cell, int group,
+        Material* material, double flux);
+void scoreCrossingTallies(std::vector <Tally> &tallies, int* cell, int axis,
+        int side, double direction, int group, Material* material,
+        double value);
+
 #endif
@@ -0,0 +1,271 @@
+/*
+ @file      Weight_windows.cpp
+ @brief     contains functions for the WeightWindows class
+ @details   a text file of weight windows holds the keyword "cells" then the
+            number of mesh cells along each axis, "groups" then the number
+            of groups, and "lower_bounds" then the lower bound of each cell
+            and group, the cells in the order of Mesh::getCellIndex() and
+            the groups of a cell together. Text after a '#' is ignored.
+ @author    Luke Eure
+ @date      April 18 2016
+*/
+
+#include "Weight_windows.h"
+
+/*
+ @brief     constructor for WeightWindows class, leaving every cell without
+            a window
+ @param     mesh the mesh whose cells the windows are set on
+ @param     num_groups the number of neutron energy groups
+*/
+WeightWindows::WeightWindows(Mesh &mesh, int num_groups) {
+    _num_groups = num_groups;
+    long num_cells = 1;
+    for (int axis=0; axis<3; ++axis) {
+        _axis_sizes[axis] = mesh.getAxisSize(axis);
+        num_cells *= _axis_sizes[axis];
+    }
+    _lower_bounds.assign(num_cells * num_groups, 0.0);
+    _upper_ratio = 5.0;
+    _survival_ratio = 3.0;
+}
+
+/*
+ @brief     deconstructor
+*/
+WeightWindows::~WeightWindows() {}
+
+/*
+ @brief     sets the width of every window and the weight neutrons surviving
+            roulette are given
+ @param     upper_ratio the upper bound of a window over its lower bound
+ @param     survival_ratio the survival weight over the lower bound, at
+            least 1 and at most upper_ratio
+*/
+void WeightWindows::setRatios(double upper_ratio, double survival_ratio) {
+    if (survival_ratio < 1.0 || survival_ratio > upper_ratio) {
+        std::cout << "The survival weight must be inside the weight window"
+            << std::endl;
+        return;
+    }
+    _upper_ratio = upper_ratio;
+    _survival_ratio = survival_ratio;
+}
+
+/*
+ @brief     sets the lower bound of the window of a mesh cell and group
+ @param     cell the mesh cell number along each axis
+ @param     group the energy group
+ @param     lower_bound the lower weight bound, or 0 for no window
+*/
+void WeightWindows::setLowerBound(int* cell, int group, double lower_bound) {
+    _lower_bounds[getIndex(cell, group)] = lower_bound;
+}
+
+/*
+ @brief     returns the lower bound of the window of a mesh cell and group
+ @param     cell the mesh cell number along each axis
+ @param     group the energy group
+ @return    the lower weight bound, 0 if the cell has no window
+*/
+double WeightWindows::getLowerBound(int* cell, int group) {
+    return _lower_bounds[getIndex(cell, group)];
+}
+
+/*
+ @brief     sets the windows from the flux of a previous run on the mesh
+ @details   the lower bound of each cell and group is made proportional to
+            the flux per unit volume, taking the importance of a cell to be
+            the inverse of its flux, and scaled so that the window of the
+            cell with the most flux in the group is centred on the weight of
+            a source neutron. Neutrons reaching cells of little flux are
+            split into many of low weight. Cells and groups without flux are
+            left without a window. Running again with these windows and
+            generating from the new flux refines them.
+ @param     mesh the mesh, whose flux must be tallied on its own cells
+ @return    true if the windows were set
+*/
+bool WeightWindows::generate(Mesh &mesh) {
+    if (!mesh.getFluxOnMesh()) {
+        std::cout << "Weight windows can only be generated from a flux "
+            << "tallied on the mesh" << std::endl;
+        return false;
+    }
+    FluxView flux = mesh.getFlux();
+    long num_cells = _lower_bounds.size() / _num_groups;
+    std::vector <double> flux_density(_lower_bounds.size());
+    std::vector <double> max_density(_num_groups, 0.0);
+    for (long index=0; index<num_cells; ++index) {
+        int cell[3] = {(int) (index / _axis_sizes[2] / _axis_sizes[1]),
+            (int) (index / _axis_sizes[2] % _axis_sizes[1]),
+            (int) (index % _axis_sizes[2])};
+        double mins[3];
+        double maxes[3];
+        mesh.getCellMin(cell, mins);
+        mesh.getCellMax(cell, maxes);
+        double volume = (maxes[0] - mins[0]) * (maxes[1] - mins[1])
+            * (maxes[2] - mins[2]);
+        for (int g=0; g<_num_groups; ++g) {
+            double density = flux.getValue(cell, g) / volume;
+            flux_density[getIndex(cell, g)] = density;
+            if (density > max_density[g])
+                max_density[g] = density;
+        }
+    }
+
+    // a window [l, r l] is centred on 1 when l = 2 / (1 + r)
+    double center_bound = 2.0 / (1.0 + _upper_ratio);
+    for (long i=0; i<_lower_bounds.size(); ++i) {
+        double max = max_density[i % _num_groups];
+        _lower_bounds[i] = max > 0.0 ? center_bound * flux_density[i] / max
+            : 0.0;
+    }
+    return true;
+}
+
+/*
+ @brief     reads the lower bounds of the windows from a text file
+ @param     file_name the name of the file
+ @return    true if the file held a bound for every cell and group of the
+            mesh
+*/
+bool WeightWindows::readFile(std::string file_name) {
+    std::ifstream file(file_name.c_str());
+    if (!file) {
+        std::cout << "Could not open weight windows " << file_name
+            << std::endl;
+        return false;
+    }
+    std::vector <std::string> tokens;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::string word;
+        while (words >> word)
+            tokens.push_back(word);
+    }
+
+    // the file must describe the cells and groups of the mesh
+    const char* keywords[3] = {"cells", "groups", "lower_bounds"};
+    long counts[3] = {3, 1, (long) _lower_bounds.size()};
+    std::vector <double> values;
+    long position = 0;
+    bool read = true;
+    for (int k=0; k<3 && read; ++k) {
+        read = position < tokens.size() && tokens[position++] == keywords[k]
+            && position + counts[k] <= tokens.size();
+        if (k == 0) {
+            for (int axis=0; axis<3 && read; ++axis)
+                read = atoi(tokens[position + axis].c_str())
+                    == _axis_sizes[axis];
+        }
+        else if (k == 1) {
+            read = read && atoi(tokens[position].c_str()) == _num_groups;
+        }
+        else {
+            values.resize(counts[k]);
+            for (long i=0; i<counts[k] && read; ++i) {
+                const char* word = tokens[position + i].c_str();
+                char* end;
+                values[i] = strtod(word, &end);
+                read = end != word && *end == '\0' && values[i] >= 0.0;
+            }
+        }
+        position += counts[k];
+    }
+    if (!read || position != tokens.size()) {
+        std::cout << "Weight windows " << file_name << " do not match the "
+            << "mesh" << std::endl;
+        return false;
+    }
+    _lower_bounds.swap(values);
+    return true;
+}
+
+/*
+ @brief     writes the lower bounds of the windows to a text file that
+            readFile() can load
+ @param     file_name the name of the file
+ @return    true if the file was written
+*/
+bool WeightWindows::writeFile(std::string file_name) {
+    std::ofstream file(file_name.c_str());
+    if (!file) {
+        std::cout << "Could not open weight windows " << file_name
+            << std::endl;
+        return false;
+    }
+    file.precision(17);
+    file << "cells " << _axis_sizes[0] << " " << _axis_sizes[1] << " "
+        << _axis_sizes[2] << std::endl;
+    file << "groups " << _num_groups << std::endl;
+    file << "lower_bounds" << std::endl;
+    for (long i=0; i<_lower_bounds.size(); ++i) {
+        file << _lower_bounds[i];
+        file << ((i + 1) % _num_groups == 0 ? "\n" : " ");
+    }
+    return (bool) file;
+}
+
+/*
+ @brief     brings a neutron's weight into the window of its cell and group
+ @details   a neutron below the window is rouletted and may be killed. A
+            neutron above it keeps one share of its weight and its other
+            shares are pushed onto split_neutrons, each drawing its own
+            random numbers. Splitting stops short rather than grow
+            split_neutrons past its capacity, which leaves the weights
+            unbiased and the heap untouched.
+ @param     neutron a live neutron with its cell, group and weight set
+ @param     split_neutrons the neutrons waiting to be transported, with
+            room reserved for MAX_SPLIT_NEUTRONS
+ @return    true if the cell and group have a window
+*/
+bool WeightWindows::apply(Neutron &neutron,
+        std::vector <Neutron> &split_neutrons) {
+    double lower_bound = _lower_bounds[getIndex(neutron.getCell(),
+            neutron.getGroup())];
+    if (lower_bound <= 0.0)
+        return false;
+    double weight = neutron.getWeight();
+
+    // roulette a neutron below the window
+    if (weight < lower_bound) {
+        double survival_weight = _survival_ratio * lower_bound;
+        if (neutron.arand() * survival_weight < weight)
+            neutron.setWeight(survival_weight);
+        else
+            neutron.kill();
+        return true;
+    }
+
+    // split a neutron above the window
+    double upper_bound = _upper_ratio * lower_bound;
+    if (weight <= upper_bound)
+        return true;
+    double copies = ceil(weight / upper_bound);
+    if (copies > MAX_SPLIT)
+        copies = MAX_SPLIT;
+    long room = split_neutrons.capacity() - split_neutrons.size();
+    if (copies > room + 1)
+        copies = room + 1;
+    int num_copies = (int) copies;
+    if (num_copies < 2)
+        return true;
+    neutron.setWeight(weight / num_copies);
+    for (int i=1; i<num_copies; ++i) {
+        split_neutrons.push_back(neutron);
+        neutron.branchRandomStream(split_neutrons.back());
+    }
+    return true;
+}
+
+/*
+ @brief     returns the position of a cell and group in _lower_bounds
+ @param     cell the mesh cell number along each axis
+ @param     group the energy group
+ @return    the index of the lower bound
+*/
+long WeightWindows::getIndex(int* cell, int group) {
+    return (((long) cell[0] * _axis_sizes[1] + cell[1]) * _axis_sizes[2]
+            + cell[2]) * _num_groups + group;
+}
@@ -0,0 +1,75 @@
+/*
+ @file      Weight_windows.h
+ @brief     contains the WeightWindows class
+ @author    Luke Eure
+ @date      April 18 2016
+*/
+
+#ifndef WEIGHT_WINDOWS_H
+#define WEIGHT_WINDOWS_H
+
+#include <stdlib.h>
+#include <math.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+
+#include "Mesh.h"
+#include "Neutron.h"
+
+/** most neutrons a thread holds split off the neutron it is following and
+    not yet transported, so splitting never allocates */
+const int MAX_SPLIT_NEUTRONS = 256;
+
+/** most copies a neutron is split into at once */
+const int MAX_SPLIT = 10;
+
+/*
+ @brief     weight windows on the cells of the Mesh, which split neutrons
+            heading into important regions and roulette those leaving them
+ @details   each mesh cell and group has a lower weight bound, and the
+            upper bound is a fixed multiple of it. A neutron above the
+            window is split into copies of equal weight within it, and a
+            neutron below it plays Russian roulette for the survival weight
+            inside it, so the expected weight is always kept. Bounds in
+            inverse proportion to the flux spend about the same effort on
+            every cell, evening out the statistics of deep penetration
+            problems. A lower bound of zero leaves the cell without a
+            window.
+*/
+class WeightWindows {
+
+public:
+    WeightWindows(Mesh &mesh, int num_groups);
+    virtual ~WeightWindows();
+
+    void setRatios(double upper_ratio, double survival_ratio);
+    void setLowerBound(int* cell, int group, double lower_bound);
+    double getLowerBound(int* cell, int group);
+    bool generate(Mesh &mesh);
+    bool readFile(std::string file_name);
+    bool writeFile(std::string file_name);
+    bool apply(Neutron &neutron, std::vector <Neutron> &split_neutrons);
+
+private:
+    long getIndex(int* cell, int group);
+
+    /** number of mesh cells along each axis */
+    int _axis_sizes[3];
+
+    /** number of neutron energy groups */
+    int _num_groups;
+
+    /** lower weight bound of each mesh cell and group, the groups of a
+        cell stored together */
+    std::vector <double> _lower_bounds;
+
+    /** upper bound and survival weight of each window as multiples of its
+        lower bound */
+    double _upper_ratio;
+    double _survival_ratio;
+};
+
+#endif